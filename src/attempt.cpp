@@ -1,609 +1,996 @@
-#include <iostream>
-#include <fstream>
-#include <cstdlib>
-#include <ctime>
-#include <array>
-#include<vector>
-#include<set>
-
-enum SPOT_STATE {
-    EMPTY = 0,
-    BLACK = 1,
-    WHITE = 2
-};
-
-#define TIMEOUT 10
-#define INFINITY 10000000
-#define SIZE 15
-
-struct Point {
-    int x, y;
-    Point() : Point(0, 0) {}
-    Point(float x, float y) : x(x), y(y) {}
-    bool operator==(const Point& rhs) const {
-        return x == rhs.x && y == rhs.y;
-    }
-    bool operator!=(const Point& rhs) const {
-        return !operator==(rhs);
-    }
-    Point operator+(const Point& rhs) const {
-        return Point(x + rhs.x, y + rhs.y);
-    }
-    Point operator-(const Point& rhs) const {
-        return Point(x - rhs.x, y - rhs.y);
-    }
-};
-
-class GomokuBoard {
-public:
-    int board[15][15];
-    std::set<std::pair<int, int>> blackpos;
-    std::set<std::pair<int, int>> whitepos;
-    int empty_count;
-    int cur_player;
-    int thisplayer;
-    Point nextstep=Point(5,4);
-private:
-    int get_next_player(int player) const {
-        return 3 - player;
-    }
-    bool is_spot_on_board(Point p) const {
-        if (p.x < 0)
-            return false;
-        if (p.x >= SIZE) {
-            return false;
-        }
-        if (p.y < 0)
-            return false;
-        if (p.y >= SIZE)
-            return false;
-        return true;
-    }
-    int get_disc(Point p) const {
-        return board[p.x][p.y];
-    }
-    void set_disc(Point p, int disc) {
-        board[p.x][p.y] = disc;
-    }
-    bool is_disc_at(Point p, int disc) const {
-        if (!is_spot_on_board(p))
-            return false;
-        if (get_disc(p) != disc)
-            return false;
-        return true;
-    }
-    bool is_spot_valid(Point center) const {
-        if (!is_spot_on_board(center)) {
-            return false;
-        }
-        if (get_disc(center) != EMPTY)
-            return false;
-        return true;
-    }
-
-public:
-    GomokuBoard() {
-        reset();
-    }
-    void reset() {
-        for (int i = 0; i < SIZE; i++) {
-            for (int j = 0; j < SIZE; j++) {
-                board[i][j] = EMPTY;
-            }
-        }
-        cur_player = BLACK;
-        empty_count = SIZE * SIZE;
-        thisplayer = BLACK;
-    }
-    bool put_disc(Point p) {
-        if (!is_spot_valid(p)) {
-            return false;
-        }
-        set_disc(p, cur_player);
-        empty_count--;
-        // Check Win
-        // Give control to the other player.
-        cur_player = get_next_player(cur_player);
-        return true;
-    }
-    int count_value(GomokuBoard state, int cur) {
-        int consec;
-        int value = 0;
-        for (int i = 0; i < SIZE; i++) {
-            for (int j = 0; j < SIZE; j++) {
-                if (state.board[i][j] == cur) {
-                    consec++;
-                }
-                else if(state.board[i][j]==EMPTY){
-                    switch(consec) {
-                        case 4:
-                            value += 100;
-                            break;
-                        case 3:
-                            value += 40;
-                            break;
-                        case 2:
-                            value += 10;
-                            break;
-                        case 1:
-                            value += 2;
-                            break;
-                        case 0:
-                            break;
-                        default:
-                            value += INFINITY;
-                    }
-                    consec = 0;
-                }
-                else if (state.board[i][j] == get_next_player(cur)) {
-                    switch (consec) {
-                    case 4:
-                        value += 70;
-                        break;
-                    case 3:
-                        value += 30;
-                        break;
-                    case 2:
-                        value += 5;
-                        break;
-                    case 1:
-                        value += 1;
-                        break;
-                    case 0:
-                        break;
-                    default:
-                        value += INFINITY;
-                    }
-                    consec = 0;
-                }
-            }
-        }
-
-        for (int j = 0; j < SIZE; j++) {
-            for (int i = 0; i < SIZE; i++) {
-                if (state.board[i][j] == cur) {
-                    consec++;
-                }
-                else if (state.board[i][j] == EMPTY) {
-                    switch (consec) {
-                    case 4:
-                        value += 100;
-                        break;
-                    case 3:
-                        value += 40;
-                        break;
-                    case 2:
-                        value += 10;
-                        break;
-                    case 1:
-                        value += 2;
-                        break;
-                    case 0:
-                        break;
-                    default:
-                        value += INFINITY;
-                    }
-                    consec = 0;
-                }
-                else if (state.board[i][j] == get_next_player(cur)) {
-                    switch (consec) {
-                    case 4:
-                        value += 70;
-                        break;
-                    case 3:
-                        value += 30;
-                        break;
-                    case 2:
-                        value += 5;
-                        break;
-                    case 1:
-                        value += 1;
-                        break;
-                    case 0:
-                        break;
-                    default:
-                        value += INFINITY;
-                    }
-                    consec = 0;
-                }
-            }
-        }
-
-        for (int k = 0; k <= 2 * (SIZE - 1); k++) {
-            int ibegin = 0, iend=SIZE-1;
-            if (ibegin < k - SIZE + 1) {
-                ibegin = k - SIZE + 1;
-            }
-            if (iend > k) {
-                iend = k;
-            }
-            for (int i = ibegin; i <= iend; i++) {
-                int j = k - i;
-
-                if (state.board[i][j] == cur) {
-                    consec++;
-                }
-                else if (state.board[i][j] == 0) {
-                    switch (consec) {
-                    case 4:
-                        value += 100;
-                        break;
-                    case 3:
-                        value += 40;
-                        break;
-                    case 2:
-                        value += 10;
-                        break;
-                    case 1:
-                        value += 2;
-                        break;
-                    case 0:
-                        break;
-                    default:
-                        value += INFINITY;
-                    }
-                }
-                else if (state.board[i][j] == get_next_player(cur)) {
-                    switch (consec) {
-                    case 4:
-                        value += 70;
-                        break;
-                    case 3:
-                        value += 30;
-                        break;
-                    case 2:
-                        value += 5;
-                        break;
-                    case 1:
-                        value += 1;
-                        break;
-                    case 0:
-                        break;
-                    default:
-                        value += INFINITY;
-                    }
-                    consec = 0;
-                }
-            }
-        }
-
-        for (int k = 1-SIZE; k < SIZE; k++) {
-            int ibegin = 0, iend = SIZE+k-1;
-            if (ibegin < k) {
-                ibegin = k;
-            }
-            if (iend > SIZE-1) {
-                iend = SIZE-1;
-            }
-            for (int i = ibegin; i <= iend; i++) {
-                int j = i-k;
-
-                if (state.board[i][j] == cur) {
-                    consec++;
-                }
-                else if (state.board[i][j] == 0) {
-                    switch (consec) {
-                    case 4:
-                        value += 100;
-                        break;
-                    case 3:
-                        value += 40;
-                        break;
-                    case 2:
-                        value += 10;
-                        break;
-                    case 1:
-                        value += 2;
-                        break;
-                    case 0:
-                        break;
-                    default:
-                        value += INFINITY;
-                    }
-                }
-                else if (state.board[i][j] == get_next_player(cur)) {
-                    switch (consec) {
-                    case 4:
-                        value += 70;
-                        break;
-                    case 3:
-                        value += 30;
-                        break;
-                    case 2:
-                        value += 5;
-                        break;
-                    case 1:
-                        value += 1;
-                        break;
-                    case 0:
-                        break;
-                    default:
-                        value += INFINITY;
-                    }
-                    consec = 0;
-                }
-            }
-
-        }
-        return value;
-    }
-
-
-    void read_board(std::ifstream& fin) {
-        fin >> thisplayer;
-        int temp;
-        int black=0, white=0;
-        for (int i = 0; i < SIZE; i++) {
-            for (int j = 0; j < SIZE; j++) {
-                fin >> temp;
-                board[i][j] = temp;
-                if (temp == BLACK) {
-                    blackpos.insert(std::make_pair(i, j));
-                    black++;
-                    empty_count--;
-                }
-                else if (temp == WHITE) {
-                    whitepos.insert(std::make_pair(i, j));
-                    white++;
-                    empty_count--;
-                }
-            }
-        }
-        if (black > white) {
-            thisplayer = WHITE;
-        }
-        else if (black == white) {
-            thisplayer = BLACK;
-        }
-        else {
-            thisplayer = 10000000;
-        }
-    }
-
-    void next_step() {
-        if (empty_count == SIZE * SIZE) {
-            cur_player = BLACK;
-            nextstep=Point(7,7);
-        }
-        else if (empty_count == (SIZE * SIZE) - 1) {
-            cur_player = WHITE;
-            auto it = blackpos.begin();
-            Point p = Point((*it).first, (*it).second);
-            if (put_disc(Point(p.x + 1, p.y))) {
-                nextstep= Point(p.x + 1, p.y);
-            }
-            else if (put_disc(Point(p.x, p.y + 1))) {
-                nextstep= Point(p.x, p.y + 1);
-            }
-            else if (put_disc(Point(p.x - 1, p.y))) {
-                nextstep= Point(p.x - 1, p.y);
-            }
-            else if (put_disc(Point(p.x, p.y + 1))) {
-                nextstep= Point(p.x, p.y + 1);
-            }
-            else if (put_disc(Point(p.x+1, p.y + 1))) {
-                nextstep = Point(p.x+1, p.y + 1);
-            }
-            else if (put_disc(Point(p.x-1, p.y + 1))) {
-                nextstep = Point(p.x-1, p.y + 1);
-            }
-            else if (put_disc(Point(p.x+1, p.y - 1))) {
-                nextstep = Point(p.x+1, p.y - 1);
-            }
-            else if (put_disc(Point(p.x-1, p.y - 1))) {
-                nextstep = Point(p.x-1, p.y - 1);
-            }
-        }
-        Minimax(*this, 4, true);
-        return ;
-    }
-        
-    int Minimax(GomokuBoard state, int depth, bool isMax) {
-        std::set<std::pair<int, int>> poscopy;
-        if (thisplayer == BLACK) {
-            poscopy = blackpos;
-        }
-        else {
-            poscopy = whitepos;
-        }
-        int blackval, whiteval;
-        int value;
-        if (depth == 0) {
-            blackval = count_value(state, BLACK);
-            whiteval = count_value(state, WHITE);
-
-            if (thisplayer == BLACK) {
-                value = blackval - whiteval;
-            }
-            else {
-                value = whiteval - blackval;
-            }
-            return value;
-        }
-        if (isMax) {
-            value = 0 - INFINITY;
-            int temp;
-            while (!poscopy.empty()) {
-                auto it = poscopy.begin();
-                Point p = Point((*it).first, (*it).second);
-                GomokuBoard tempstate = state;
-                tempstate.cur_player = thisplayer;
-                if (tempstate.put_disc(Point(p.x + 1, p.y))) {
-                    temp = Minimax(tempstate, depth - 1, false);
-                    if (temp > value) {
-                        value = temp;
-                        nextstep = Point(p.x + 1, p.y);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = thisplayer;
-                if (tempstate.put_disc(Point(p.x - 1, p.y))) {
-                    temp = Minimax(tempstate, depth - 1, false);
-                    if (temp > value) {
-                        value = temp;
-                        nextstep = Point(p.x - 1, p.y);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = thisplayer;
-                if (tempstate.put_disc(Point(p.x, p.y+1))) {
-                    temp = Minimax(tempstate, depth - 1, false);
-                    if (temp > value) {
-                        value = temp;
-                        nextstep = Point(p.x, p.y + 1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = thisplayer;
-                if (tempstate.put_disc(Point(p.x + 1, p.y-1))) {
-                    temp = Minimax(tempstate, depth - 1, false);
-                    if (temp > value) {
-                        value = temp;
-                        nextstep = Point(p.x + 1, p.y-1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = thisplayer;
-                if (tempstate.put_disc(Point(p.x + 1, p.y+1))) {
-                    temp = Minimax(tempstate, depth - 1, false);
-                    if (temp > value) {
-                        value = temp;
-                        nextstep = Point(p.x + 1, p.y+1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = thisplayer;
-                if (tempstate.put_disc(Point(p.x + 1, p.y-1))) {
-                    temp = Minimax(tempstate, depth - 1, false);
-                    if (temp > value) {
-                        value = temp;
-                        nextstep = Point(p.x + 1, p.y-1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = thisplayer;
-                if (tempstate.put_disc(Point(p.x - 1, p.y - 1))) {
-                    temp = Minimax(tempstate, depth - 1, false);
-                    if (temp > value) {
-                        value = temp;
-                        nextstep = Point(p.x - 1, p.y-1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = thisplayer;
-                if (tempstate.put_disc(Point(p.x - 1, p.y + 1))) {
-                    temp = Minimax(tempstate, depth - 1, false);
-                    if (temp > value) {
-                        value = temp;
-                        nextstep = Point(p.x - 1, p.y+1);
-                    }
-                }
-                poscopy.erase(it);
-            }
-        }
-        else {
-            value = INFINITY;
-            int temp = 0;
-            while (!poscopy.empty()) {
-                auto it = poscopy.begin();
-                Point p = Point((*it).first, (*it).second);
-                GomokuBoard tempstate = state;
-                tempstate.cur_player = get_next_player(thisplayer);
-                if (tempstate.put_disc(Point(p.x + 1, p.y))) {
-                    temp = Minimax(tempstate, depth - 1, true);
-                    if (temp < value) {
-                        value = temp;
-                        nextstep = Point(p.x + 1, p.y);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = get_next_player(thisplayer);
-                if (tempstate.put_disc(Point(p.x - 1, p.y))) {
-                    temp = Minimax(tempstate, depth - 1, true);
-                    if (temp < value) {
-                        value = temp;
-                        nextstep = Point(p.x - 1, p.y);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = get_next_player(thisplayer);
-                if (tempstate.put_disc(Point(p.x, p.y + 1))) {
-                    temp = Minimax(tempstate, depth - 1, true);
-                    if (temp < value) {
-                        value = temp;
-                        nextstep = Point(p.x, p.y+1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = get_next_player(thisplayer);
-                if (tempstate.put_disc(Point(p.x, p.y - 1))) {
-                    temp = Minimax(tempstate, depth - 1, true);
-                    if (temp < value) {
-                        value = temp;
-                        nextstep = Point(p.x, p.y-1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = get_next_player(thisplayer);
-                if (tempstate.put_disc(Point(p.x + 1, p.y + 1))) {
-                    temp = Minimax(tempstate, depth - 1, true);
-                    if (temp < value) {
-                        value = temp;
-                        nextstep = Point(p.x + 1, p.y+1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = get_next_player(thisplayer);
-                if (tempstate.put_disc(Point(p.x + 1, p.y - 1))) {
-                    temp = Minimax(tempstate, depth - 1, true);
-                    if (temp < value) {
-                        value = temp;
-                        nextstep = Point(p.x + 1, p.y-1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = get_next_player(thisplayer);
-                if (tempstate.put_disc(Point(p.x - 1, p.y - 1))) {
-                    temp = Minimax(tempstate, depth - 1, true);
-                    if (temp < value) {
-                        value = temp;
-                        nextstep = Point(p.x - 1, p.y-1);
-                    }
-                }
-                tempstate = state;
-                tempstate.cur_player = get_next_player(thisplayer);
-                if (tempstate.put_disc(Point(p.x - 1, p.y + 1))) {
-                    temp = Minimax(tempstate, depth - 1, true);
-                    if (temp < value) {
-                        value = temp;
-                        nextstep = Point(p.x - 1, p.y+1);
-                    }
-                }
-                poscopy.erase(it);
-            }
-            return value;
-        }
-    }
-
-};
-
-const std::string file_log = "gamelog.txt";
-const std::string file_state = "state";
-const std::string file_action = "action";
-const int timeout = TIMEOUT;
-
-GomokuBoard game;
-
-int main(int, char** argv) {
-    std::ifstream fin(argv[1]);
-    std::ofstream fout(argv[2]);
-    game.read_board(fin);
-    fout << 5 << " " << 4 << std::endl;
-    fout.flush();
-    game.next_step();
-    fout << game.nextstep.x << " " << game.nextstep.y << std::endl;
-    fout.flush();
-    fin.close();
-    fout.close();
-    return 0;
-}
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <ctime>
+#include <array>
+#include<vector>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <sstream>
+#include <unordered_set>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+#include "bitboard.h"
+#include "evaluate.h"
+#include "zobrist.h"
+#include "transposition.h"
+#include "movegen.h"
+#include "threats.h"
+#include "mcts.h"
+#include "book.h"
+#include "state_format.h"
+#include "stats.h"
+#include "ordering.h"
+
+#define TIMEOUT 10
+// Bound of every search score; <cmath>'s INFINITY is a float.
+#define SCORE_INF 10000000
+#define WIN_SCORE (SCORE_INF - 1000)
+#define MAX_PLY 64
+#define MAX_DEPTH 40
+#define TIME_MARGIN_MS 1000
+// Under a clock, the moves the time left is spread over.
+#define CLOCK_MOVES 30
+#define MAX_THREADS 8
+#define VCF_DEPTH 16
+#define VCT_DEPTH 6
+#define VCT_AFTER_DEPTH 4
+#define THREAT_NODES 2000000
+#define BENCH_DEPTH 6
+// Half-width of the first aspiration window, in evaluation units.
+#define ASPIRATION_WINDOW 50
+#ifndef TT_MEGABYTES
+#define TT_MEGABYTES 64
+#endif
+// A file-mode move starts with an empty table, so a short move gets a
+// smaller one: this many megabytes per second of search, at least one.
+#define TT_MEGABYTES_PER_SECOND 16
+#ifndef BOOK_FILE
+#define BOOK_FILE "book.bin"
+#endif
+#ifndef MCTS_MEGABYTES
+#define MCTS_MEGABYTES 256
+#endif
+
+const int SIZE = BitBoard::SIZE;
+static_assert(STATE_SIZE == BitBoard::SIZE && STATE_WIN_LENGTH == BitBoard::WIN_LENGTH, "state file and board are built for different games");
+
+struct PVLine {
+    int length;
+    Point moves[MAX_PLY];
+};
+
+TranspositionTable tt;
+OpeningBook book;
+// Made by the first MCTS search. In protocol mode it stays for the next
+// move, which goes on from the subtree of the position reached.
+std::unique_ptr<MctsTree> mcts_tree;
+// Each search thread orders its moves from its own tables.
+thread_local MoveOrdering ordering;
+static_assert(TranspositionTable::NO_MOVE == MoveOrdering::NO_MOVE, "hash moves go straight to the ordering");
+
+// One ply of a search thread's stack: the ply's move list and what undoing
+// the move being searched needs. The search makes and unmakes moves on one
+// board, so nothing is copied or allocated per node. CandidateMask only ever
+// ORs cells in and cannot take a stone back, so it is saved whole.
+struct SearchFrame {
+    Point moves[CandidateMask::MAX_MOVES];
+    int scores[CandidateMask::MAX_MOVES];
+    CandidateMask candidates;
+    Evaluator::Undo eval;
+};
+thread_local SearchFrame search_stack[MAX_PLY];
+static_assert(MAX_PLY <= ORDERING_MAX_PLY, "ordering tables are too short for MAX_PLY");
+
+// Move time budget. The arbiter stops the player the move's time after it
+// was launched (TIMEOUT seconds unless it says otherwise), so the clock
+// starts with the program; in protocol mode it starts with each "go".
+// hard_ms is never exceeded;
+// a new iteration is only started while it is expected to finish within
+// hard_ms and the soft budget, which shrinks while the best move stays the
+// same and grows while it keeps changing.
+struct TimeManager {
+    std::chrono::steady_clock::time_point start;
+    int hard_ms;
+    int soft_ms;
+
+    TimeManager() {
+        start_move(TIMEOUT * 1000);
+    }
+    // Budget for a move that must be made within move_ms from now.
+    void start_move(int move_ms, int inc_ms = -1) {
+        start = std::chrono::steady_clock::now();
+        set_limit(move_ms, inc_ms);
+    }
+    // Budget for a move due move_ms after start. The margin shrinks for short
+    // moves, where no process startup eats into it. Under a clock (inc_ms
+    // >= 0) move_ms is all the time left, of which a move takes about a
+    // CLOCK_MOVES'th plus the increment.
+    void set_limit(int move_ms, int inc_ms = -1) {
+        hard_ms = move_ms - (TIME_MARGIN_MS < move_ms / 10 ? TIME_MARGIN_MS : move_ms / 10);
+        if (inc_ms >= 0) {
+            hard_ms = std::min(hard_ms, 4 * (move_ms / CLOCK_MOVES + inc_ms));
+        }
+        soft_ms = hard_ms / 4;
+    }
+    int elapsed_ms() const {
+        return (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    // Fixed budget for one search, for the book builder.
+    void restart(int budget_ms) {
+        start = std::chrono::steady_clock::now();
+        hard_ms = budget_ms;
+        soft_ms = budget_ms;
+    }
+    bool hard_expired() const {
+        return elapsed_ms() >= hard_ms;
+    }
+    bool next_iteration(int last_iteration_ms, int stable) const {
+        int elapsed = elapsed_ms();
+        int budget = stable >= 3 ? soft_ms / 2 : stable == 0 ? soft_ms * 3 / 2 : soft_ms;
+        if (elapsed >= budget) {
+            return false;
+        }
+        // The next iteration typically takes a few times as long as the last.
+        return elapsed + 3 * last_iteration_ms < hard_ms;
+    }
+};
+
+TimeManager timer;
+
+std::atomic<bool> search_stopped(false);
+
+#ifdef SEARCH_STATS
+// Counters of the thread running the search, and where helper threads leave
+// theirs when they finish.
+thread_local SearchStats stats;
+std::vector<SearchStats> helper_stats;
+#endif
+
+// Search threads: GOMOKU_THREADS if set, otherwise one per core up to
+// MAX_THREADS.
+int thread_count() {
+    const char* env = getenv("GOMOKU_THREADS");
+    int n = env ? atoi(env) : (int)std::thread::hardware_concurrency();
+    if (n > MAX_THREADS && !env) {
+        n = MAX_THREADS;
+    }
+    return n < 1 ? 1 : n;
+}
+
+// Search engine: alpha-beta, or MCTS when built with -DENGINE_MCTS.
+// GOMOKU_ENGINE=mcts or GOMOKU_ENGINE=alphabeta overrides the build.
+bool use_mcts() {
+    const char* env = getenv("GOMOKU_ENGINE");
+    if (env) {
+        return std::string(env) == "mcts";
+    }
+#ifdef ENGINE_MCTS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Search trace on stderr (book hits, iterations, thread totals, threat and
+// MCTS results), only with GOMOKU_VERBOSE set: in a tournament every player
+// shares the arbiter's terminal.
+bool verbose() {
+    static const bool on = getenv("GOMOKU_VERBOSE") != nullptr;
+    return on;
+}
+
+// Win scores are stored relative to the node rather than the root so a
+// transposition reached at another ply still reports the right distance.
+int score_to_tt(int value, int ply) {
+    if (value > WIN_SCORE - MAX_PLY)
+        return value + ply;
+    if (value < -(WIN_SCORE - MAX_PLY))
+        return value - ply;
+    return value;
+}
+int score_from_tt(int value, int ply) {
+    if (value > WIN_SCORE - MAX_PLY)
+        return value - ply;
+    if (value < -(WIN_SCORE - MAX_PLY))
+        return value + ply;
+    return value;
+}
+
+class GomokuBoard {
+public:
+    BitBoard board;
+    Evaluator eval;
+    uint64_t hash;
+    CandidateMask candidates;
+    int empty_count;
+    int cur_player;
+    int thisplayer;
+    Point nextstep=Point(5,4);
+    long long nodes;
+private:
+    int get_next_player(int player) const {
+        return 3 - player;
+    }
+    bool is_spot_on_board(Point p) const {
+        return BitBoard::is_on_board(p.x, p.y);
+    }
+    int get_disc(Point p) const {
+        return board.get(p.x, p.y);
+    }
+    void set_disc(Point p, int disc) {
+        board.place(p.x, p.y, disc);
+        eval.update(board, p.x, p.y);
+        hash ^= zobrist_key(p.x, p.y, disc);
+        candidates.add_stone(p.x, p.y);
+    }
+    bool is_disc_at(Point p, int disc) const {
+        if (!is_spot_on_board(p))
+            return false;
+        if (get_disc(p) != disc)
+            return false;
+        return true;
+    }
+    bool is_spot_valid(Point center) const {
+        if (!is_spot_on_board(center)) {
+            return false;
+        }
+        if (get_disc(center) != EMPTY)
+            return false;
+        return true;
+    }
+
+public:
+    GomokuBoard() {
+        reset();
+    }
+    void reset() {
+        board.reset();
+        eval.reset(board);
+        hash = 0;
+        candidates.reset();
+        cur_player = BLACK;
+        empty_count = SIZE * SIZE;
+        thisplayer = BLACK;
+    }
+    bool put_disc(Point p) {
+        if (!is_spot_valid(p)) {
+            return false;
+        }
+        set_disc(p, cur_player);
+        empty_count--;
+        // Check Win
+        // Give control to the other player.
+        cur_player = get_next_player(cur_player);
+        return true;
+    }
+    // put_disc for the search: places a stone for cur_player on an empty
+    // cell and saves in frame what unmake_move needs.
+    void make_move(Point p, SearchFrame& frame) {
+        frame.candidates = candidates;
+        board.place(p.x, p.y, cur_player);
+        eval.update(board, p.x, p.y, frame.eval);
+        hash ^= zobrist_key(p.x, p.y, cur_player);
+        candidates.add_stone(p.x, p.y);
+        empty_count--;
+        cur_player = get_next_player(cur_player);
+    }
+    void unmake_move(Point p, const SearchFrame& frame) {
+        cur_player = get_next_player(cur_player);
+        empty_count++;
+        candidates = frame.candidates;
+        hash ^= zobrist_key(p.x, p.y, cur_player);
+        eval.restore(frame.eval);
+        board.remove(p.x, p.y, cur_player);
+    }
+    // Stones of disc on the root board in row-major order.
+    int stones_of(int disc, Point* out) const {
+        int n = 0;
+        for (int x = 0; x < SIZE; x++) {
+            BitBoard::Line row = board.segment(disc, BitBoard::HORIZONTAL, x, 0);
+            while (row) {
+                int y = __builtin_ctz(row);
+                row &= row - 1;
+                out[n++] = Point(x, y);
+            }
+        }
+        return n;
+    }
+    Point first_stone(int disc) const {
+        Point p[SIZE * SIZE];
+        stones_of(disc, p);
+        return p[0];
+    }
+
+    void read_board(std::ifstream& fin) {
+        fin >> thisplayer;
+        int temp;
+        int black=0, white=0;
+        for (int i = 0; i < SIZE; i++) {
+            for (int j = 0; j < SIZE; j++) {
+                fin >> temp;
+                if (temp != EMPTY) {
+                    candidates.add_stone(i, j);
+                }
+                if (temp == BLACK) {
+                    board.place(i, j, BLACK);
+                    black++;
+                    empty_count--;
+                }
+                else if (temp == WHITE) {
+                    board.place(i, j, WHITE);
+                    white++;
+                    empty_count--;
+                }
+            }
+        }
+        eval.reset(board);
+        hash = zobrist_hash(board);
+        if (black > white) {
+            thisplayer = WHITE;
+        }
+        else if (black == white) {
+            thisplayer = BLACK;
+        }
+        else {
+            thisplayer = 10000000;
+        }
+    }
+
+    // read_board for a binary state file: replays the move list, so the
+    // cost is per stone rather than per cell.
+    void read_binary(const BinaryState& state) {
+        for (int i = 0; i < state.move_count; i++) {
+            int x = state.moves[i] / SIZE, y = state.moves[i] % SIZE;
+            int disc = state.cell(x, y);
+            if (disc == BLACK || disc == WHITE) {
+                board.place(x, y, disc);
+                candidates.add_stone(x, y);
+                empty_count--;
+            }
+        }
+        eval.reset(board);
+        hash = zobrist_hash(board);
+        thisplayer = state.to_move;
+    }
+
+    void next_step(std::ostream& fout) {
+        cur_player = thisplayer;
+        Point move;
+        if (book.lookup(hash, move) && is_spot_valid(move)) {
+            report_move(fout, move);
+            if (verbose()) {
+                std::cerr << "book " << move.x << "," << move.y << std::endl;
+            }
+            return ;
+        }
+        if (opening_move(move)) {
+            report_move(fout, move);
+            return ;
+        }
+        search(fout);
+    }
+
+    // Without a book entry the first move of the game is the centre, and
+    // White's first move is the cell next to Black's stone closest to the
+    // centre. Neither is worth a search.
+    bool opening_move(Point& move) const {
+        if (empty_count == SIZE * SIZE) {
+            move = Point(SIZE / 2, SIZE / 2);
+            return true;
+        }
+        if (empty_count != SIZE * SIZE - 1 || thisplayer != WHITE) {
+            return false;
+        }
+        Point p = first_stone(BLACK);
+        int best = -1;
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                Point q(p.x + dx, p.y + dy);
+                int cx = q.x - SIZE / 2, cy = q.y - SIZE / 2;
+                if (is_spot_valid(q) && (best < 0 || cx * cx + cy * cy < best)) {
+                    best = cx * cx + cy * cy;
+                    move = q;
+                }
+            }
+        }
+        return best >= 0;
+    }
+
+    // Threat search, then the main search, for thisplayer.
+    void search(std::ostream& fout) {
+        cur_player = thisplayer;
+        report_move(fout, fallback_move());
+        if (threat_search(fout, false, VCF_DEPTH, timer.hard_ms / 20)) {
+            return;
+        }
+        if (use_mcts()) {
+            mcts_search(fout);
+            return ;
+        }
+        // Lazy SMP: helper threads search the same root on their own copies
+        // of the board, half of them one ply deeper than the main thread,
+        // and share what they find only through the transposition table.
+        tt.new_search();
+        ordering.new_search();
+        search_stopped = false;
+        std::vector<GomokuBoard> helpers(thread_count() - 1, *this);
+#ifdef SEARCH_STATS
+        stats.clear();
+        helper_stats.assign(helpers.size(), SearchStats());
+#endif
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < helpers.size(); i++) {
+            threads.emplace_back(&GomokuBoard::helper_search, &helpers[i], (int)i + 1);
+        }
+        iterative_deepening(fout);
+        search_stopped = true;
+        long long total = nodes;
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i].join();
+            total += helpers[i].nodes;
+        }
+        if (verbose()) {
+            std::cerr << "threads " << threads.size() + 1 << " nodes " << total
+                      << " time " << timer.elapsed_ms() << "ms" << std::endl;
+        }
+#ifdef SEARCH_STATS
+        report_stats(total, (int)threads.size() + 1);
+#endif
+        return ;
+    }
+
+#ifdef SEARCH_STATS
+    // Appends the move's statistics to the file named by GOMOKU_STATS, or
+    // writes them to stderr.
+    void report_stats(long long total_nodes, int threads) const {
+        SearchStats sum = stats;
+        for (const SearchStats& helper : helper_stats) {
+            sum.add(helper);
+        }
+        const char* path = getenv("GOMOKU_STATS");
+        std::ofstream file;
+        if (path) {
+            file.open(path, std::ios::app);
+        }
+        std::ostream& out = path && file ? file : std::cerr;
+        out << "stats move " << SIZE * SIZE - empty_count + 1 << " player " << thisplayer << "\n";
+        sum.report(out, total_nodes, threads);
+    }
+#endif
+
+    void iterative_deepening(std::ostream& fout) {
+        nodes = 0;
+        int stable = 0;
+        int last_iteration_ms = 0;
+        int scores[MAX_DEPTH + 1] = {};
+        for (int depth = 1; depth <= MAX_DEPTH; depth++) {
+            int iteration_start = timer.elapsed_ms();
+            long long iteration_nodes = nodes;
+            PVLine line;
+            int value = aspiration_search(depth, depth > 2, scores[depth > 2 ? depth - 2 : 0], line);
+            scores[depth] = value;
+            if (search_stopped) {
+                break;
+            }
+            if (line.length > 0) {
+                if (line.moves[0] == nextstep) {
+                    stable++;
+                }
+                else {
+                    stable = 0;
+                    report_move(fout, line.moves[0]);
+                }
+            }
+            last_iteration_ms = timer.elapsed_ms() - iteration_start;
+#ifdef SEARCH_STATS
+            stats.iteration(depth, nodes - iteration_nodes, last_iteration_ms);
+#else
+            (void)iteration_nodes;
+#endif
+            if (verbose()) {
+                std::cerr << "depth " << depth << " score " << value << " nodes " << nodes
+                          << " time " << timer.elapsed_ms() << "ms pv";
+                for (int i = 0; i < line.length; i++) {
+                    std::cerr << " " << line.moves[i].x << "," << line.moves[i].y;
+                }
+                std::cerr << std::endl;
+            }
+            if (line.length == 0 || value > WIN_SCORE - MAX_PLY || value < -(WIN_SCORE - MAX_PLY)) {
+                break;
+            }
+            // Once the search has settled, spend part of the remaining soft
+            // budget on a deeper threat search.
+            if (depth == VCT_AFTER_DEPTH && timer.soft_ms > timer.elapsed_ms()
+                && threat_search(fout, true, VCT_DEPTH, (timer.soft_ms - timer.elapsed_ms()) / 2)) {
+                return;
+            }
+            if (!timer.next_iteration(last_iteration_ms, stable)) {
+                break;
+            }
+        }
+    }
+
+    // One iteration's root search, in a window around guess when there is
+    // one. The guess is the score of the iteration two plies back: scores
+    // swing with the side that makes the last move, so the last iteration's
+    // is a poor guess. A fail-soft score outside the window moves that side
+    // of it past the score, twice as far each time, until the score is
+    // inside; won and lost positions are searched with the full window.
+    int aspiration_search(int depth, bool have_guess, int guess, PVLine& line) {
+        ordering.age();
+        if (!have_guess || guess > WIN_SCORE - MAX_PLY || guess < -(WIN_SCORE - MAX_PLY)) {
+            return AlphaBeta(depth, -SCORE_INF, SCORE_INF, 0, line);
+        }
+        int delta = ASPIRATION_WINDOW;
+        int alpha = guess - delta, beta = guess + delta;
+        while (true) {
+            int value = AlphaBeta(depth, alpha, beta, 0, line);
+            if (search_stopped) {
+                return value;
+            }
+            if (value <= alpha && alpha > -SCORE_INF) {
+                alpha = value - delta > -SCORE_INF ? value - delta : -SCORE_INF;
+            }
+            else if (value >= beta && beta < SCORE_INF) {
+                beta = value + delta < SCORE_INF ? value + delta : SCORE_INF;
+            }
+            else {
+                return value;
+            }
+            delta *= 2;
+        }
+    }
+
+    void helper_search(int id) {
+        nodes = 0;
+        for (int depth = 1 + id % 2; depth <= MAX_DEPTH && !search_stopped; depth++) {
+            PVLine line;
+            aspiration_search(depth, false, 0, line);
+        }
+#ifdef SEARCH_STATS
+        helper_stats[id - 1] = stats;
+#endif
+    }
+
+    // Runs MCTS playouts on every search thread for the soft time budget,
+    // the same budget the alpha-beta search plans with, and reports the most
+    // visited move whenever it changes.
+    void mcts_search(std::ostream& fout) {
+        if (!mcts_tree) {
+            const char* megabytes = getenv("GOMOKU_MCTS_MB");
+            mcts_tree.reset(new MctsTree(megabytes ? atoi(megabytes) : MCTS_MEGABYTES));
+        }
+        MctsTree& tree = *mcts_tree;
+        tree.set_root(board, candidates, thisplayer);
+        search_stopped = false;
+        uint64_t seed = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::vector<std::thread> threads;
+        for (int i = 1; i < thread_count(); i++) {
+            threads.emplace_back([&tree, seed, i]() {
+                MctsRandom rng(seed + i * 0x9E3779B97F4A7C15ULL);
+                while (!search_stopped.load(std::memory_order_relaxed)) {
+                    tree.playout(rng);
+                }
+            });
+        }
+        MctsRandom rng(seed);
+        int last_report_ms = 0;
+        for (int n = 1; ; n++) {
+            tree.playout(rng);
+            if ((n & 255) != 0) {
+                continue;
+            }
+            int elapsed = timer.elapsed_ms();
+            if (elapsed >= timer.soft_ms || tree.root_moves() == 1) {
+                break;
+            }
+            if (elapsed - last_report_ms >= 100) {
+                last_report_ms = elapsed;
+                Point best = tree.best_move();
+                if (is_spot_valid(best) && best != nextstep) {
+                    report_move(fout, best);
+                }
+            }
+        }
+        search_stopped = true;
+        for (auto& t : threads) {
+            t.join();
+        }
+        Point best = tree.best_move();
+        if (is_spot_valid(best) && best != nextstep) {
+            report_move(fout, best);
+        }
+        if (verbose()) {
+            std::cerr << "mcts " << best.x << "," << best.y << " winrate " << tree.best_winrate()
+                      << " playouts " << tree.root_visits() << " nodes " << tree.node_count()
+                      << " threads " << threads.size() + 1 << " time " << timer.elapsed_ms() << "ms" << std::endl;
+        }
+    }
+
+    // Looks for a forced win by fours (VCF) or by fours and threes (VCT)
+    // within budget_ms and plays it if found.
+    bool threat_search(std::ostream& fout, bool threes, int depth, int budget_ms) {
+        ThreatSolver solver(board);
+        solver.set_limits(THREAT_NODES, timer.start + std::chrono::milliseconds(timer.elapsed_ms() + budget_ms));
+        Point win;
+        if (!solver.solve(thisplayer, threes, depth, win)) {
+            return false;
+        }
+        report_move(fout, win);
+        if (verbose()) {
+            std::cerr << (threes ? "vct " : "vcf ") << win.x << "," << win.y << " nodes " << solver.nodes
+                      << " time " << timer.elapsed_ms() << "ms" << std::endl;
+        }
+        return true;
+    }
+
+    // Anytime output: the arbiter takes the last complete "x y" line in the
+    // action file when it stops the player.
+    void report_move(std::ostream& fout, Point p) {
+        nextstep = p;
+        fout << p.x << " " << p.y << std::endl;
+        fout.flush();
+    }
+    // Something legal to fall back on before the first iteration completes.
+    Point fallback_move() const {
+        if (is_spot_valid(nextstep)) {
+            return nextstep;
+        }
+        if (is_spot_valid(Point(SIZE / 2, SIZE / 2))) {
+            return Point(SIZE / 2, SIZE / 2);
+        }
+        for (int x = 0; x < SIZE; x++) {
+            for (int y = 0; y < SIZE; y++) {
+                if (is_spot_valid(Point(x, y))) {
+                    return Point(x, y);
+                }
+            }
+        }
+        return nextstep;
+    }
+
+    // Fail-soft negamax with alpha-beta pruning on this board, which is left
+    // as it was found. Scores are from the point of view of cur_player; a
+    // five scores WIN_SCORE minus the ply it is made on, so faster wins are
+    // preferred. pv receives the best line. last_move is the move that led
+    // here, for the counter-move table.
+    int AlphaBeta(int depth, int alpha, int beta, int ply, PVLine& pv, int last_move = MoveOrdering::NO_MOVE) {
+        pv.length = 0;
+        if ((++nodes & 1023) == 0 && timer.hard_expired()) {
+            search_stopped = true;
+        }
+        if (search_stopped.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        if (depth == 0 || ply >= MAX_PLY) {
+            STAT(leaf_evals);
+            return eval.score(cur_player);
+        }
+        int alpha_orig = alpha;
+        int hash_move = MoveOrdering::NO_MOVE;
+        TTEntry entry;
+        STAT(tt_probes);
+        if (tt.probe(hash, entry)) {
+            STAT(tt_hits);
+            hash_move = entry.move;
+            int value = score_from_tt(entry.score, ply);
+            if (ply > 0 && entry.depth >= depth) {
+                if (entry.bound == TranspositionTable::BOUND_EXACT
+                    || (entry.bound == TranspositionTable::BOUND_LOWER && value >= beta)
+                    || (entry.bound == TranspositionTable::BOUND_UPPER && value <= alpha)) {
+                    STAT(tt_cutoffs);
+                    return value;
+                }
+            }
+        }
+        SearchFrame& frame = search_stack[ply];
+        Point* moves = frame.moves;
+        int* scores = frame.scores;
+        int movecount = candidates.generate(board, moves);
+        int mover = cur_player;
+        ordering.score(moves, movecount, scores, hash_move, mover, ply, last_move);
+        int best = -SCORE_INF;
+        int best_move = MoveOrdering::NO_MOVE;
+        int searched = 0;
+        PVLine line;
+        for (int n = 0; n < movecount; n++) {
+            MoveOrdering::pick(moves, scores, n, movecount);
+            Point p = moves[n];
+            int move = p.x * SIZE + p.y;
+            make_move(p, frame);
+            searched++;
+            int value;
+            if (board.is_five(p.x, p.y, mover)) {
+                value = WIN_SCORE - ply - 1;
+                line.length = 0;
+            }
+            else if (empty_count == 0) {
+                value = 0;
+                line.length = 0;
+            }
+            else {
+                // Principal variation search: the first move gets the full
+                // window, the rest a null window that only proves them no
+                // better, and are searched again if they turn out better.
+                int floor = alpha > best ? alpha : best;
+                if (searched == 1) {
+                    value = -AlphaBeta(depth - 1, -beta, -floor, ply + 1, line, move);
+                }
+                else {
+                    value = -AlphaBeta(depth - 1, -floor - 1, -floor, ply + 1, line, move);
+                    if (value > floor && value < beta && !search_stopped.load(std::memory_order_relaxed)) {
+                        value = -AlphaBeta(depth - 1, -beta, -floor, ply + 1, line, move);
+                    }
+                }
+            }
+            unmake_move(p, frame);
+            if (search_stopped.load(std::memory_order_relaxed)) {
+                return 0;
+            }
+            if (value > best) {
+                best = value;
+                best_move = move;
+                pv.moves[0] = p;
+                for (int i = 0; i < line.length; i++) {
+                    pv.moves[i + 1] = line.moves[i];
+                }
+                pv.length = line.length + 1;
+                if (best >= beta) {
+                    ordering.cutoff(move, mover, ply, depth, last_move);
+                    STAT(cutoffs);
+                    STAT_IF(searched == 1, first_move_cutoffs);
+                    break;
+                }
+            }
+        }
+        if (!searched) {
+            STAT(leaf_evals);
+            return eval.score(cur_player);
+        }
+        STAT(interior);
+        int bound = best >= beta ? TranspositionTable::BOUND_LOWER
+                  : best > alpha_orig ? TranspositionTable::BOUND_EXACT
+                  : TranspositionTable::BOUND_UPPER;
+        tt.store(hash, depth, bound, score_to_tt(best, ply), best_move);
+        return best;
+    }
+
+};
+
+// Offline book builder. Every position up to plies stones is searched for
+// ms milliseconds and its move recorded. The positions expanded from each
+// are its book move plus the width - 1 other moves the static evaluation
+// likes best, so the book also covers the likely deviations. Transpositions
+// and mirror images are only searched once.
+int build_book(const char* path, int plies, int width, int ms) {
+    std::vector<BookEntry> entries;
+    std::vector<GomokuBoard> frontier(1);
+    std::unordered_set<uint64_t> seen;
+    for (int ply = 0; ply < plies && !frontier.empty(); ply++) {
+        std::vector<GomokuBoard> next;
+        for (size_t i = 0; i < frontier.size(); i++) {
+            GomokuBoard& position = frontier[i];
+            position.thisplayer = position.cur_player;
+            Point best;
+            // The empty board has no candidates to search.
+            if (!(ply == 0 && position.opening_move(best))) {
+                timer.restart(ms);
+                std::ostringstream discard;
+                position.search(discard);
+                best = position.nextstep;
+            }
+            std::cerr << "book ply " << ply << " position " << i + 1 << "/" << frontier.size()
+                      << " move " << best.x << "," << best.y << std::endl;
+            for (int symmetry = 0; symmetry < 8; symmetry++) {
+                BookEntry e = BookEntry();
+                Point t = book_transform(best, symmetry);
+                e.key = book_hash(position.board, symmetry);
+                e.move = t.x * SIZE + t.y;
+                e.ply = ply;
+                entries.push_back(e);
+            }
+            if (ply + 1 == plies) {
+                continue;
+            }
+            Point moves[CandidateMask::MAX_MOVES];
+            int movecount = position.candidates.generate(position.board, moves);
+            std::vector<std::pair<int, int> > ranked;
+            for (int n = 0; n < movecount; n++) {
+                GomokuBoard child = position;
+                if (moves[n] != best && child.put_disc(moves[n])) {
+                    ranked.push_back(std::make_pair(-child.eval.score(position.cur_player), n));
+                }
+            }
+            std::sort(ranked.begin(), ranked.end());
+            std::vector<Point> children(1, best);
+            for (size_t n = 0; n < ranked.size() && (int)children.size() < width; n++) {
+                children.push_back(moves[ranked[n].second]);
+            }
+            for (const Point& p : children) {
+                GomokuBoard child = position;
+                if (!child.put_disc(p) || child.board.is_five(p.x, p.y, position.cur_player)) {
+                    continue;
+                }
+                uint64_t canonical = book_hash(child.board, 0);
+                for (int symmetry = 1; symmetry < 8; symmetry++) {
+                    canonical = std::min(canonical, book_hash(child.board, symmetry));
+                }
+                if (seen.insert(canonical).second) {
+                    next.push_back(child);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+    if (!OpeningBook::write(path, entries)) {
+        std::cerr << "cannot write " << path << std::endl;
+        return 1;
+    }
+    std::cerr << "wrote " << entries.size() << " entries to " << path << std::endl;
+    return 0;
+}
+
+const std::string file_log = "gamelog.txt";
+const std::string file_state = "state";
+const std::string file_action = "action";
+const int timeout = TIMEOUT;
+
+GomokuBoard game;
+
+// Positions for "attempt bench", as moves from the empty board: the opening,
+// early and middle game of engine games, with either side to move.
+const char* const bench_positions[] = {
+    "7 7",
+    "7 7 6 7 8 6 6 8",
+    "7 7 6 7 8 8 6 6 6 5 5 6 7 9 7 6",
+    "7 7 6 7 8 6 9 6 7 5 7 8 6 4 9 7 9 5",
+    "7 7 6 7 6 6 7 6 8 8 9 9 8 5 5 5 5 4 8 7 7 5 9 8",
+    "7 7 6 7 8 6 6 8 6 6 5 6 7 8 7 5 5 5 8 8 7 9 7 10 6 9 4 7 9 6 5 10 9 5 6 5",
+    "7 7 6 7 8 8 6 6 6 5 5 6 7 9 7 6 8 6 8 5 9 4 4 6 3 6 4 5 7 8 5 8 4 9 5 9",
+    "7 7 6 7 6 6 7 6 8 8 9 9 8 5 5 5 5 4 8 7 7 5 9 8 5 7 10 9",
+};
+
+// attempt bench [depth]: searches every bench position to a fixed depth on
+// one thread, each from an empty transposition table, and prints the
+// totals. The signature hashes every position's node count, score and best
+// move, so it changes whenever the search does and stays the same when only
+// its speed does.
+int run_bench(int depth) {
+    timer.restart(1 << 30);
+    long long total = 0;
+    uint64_t signature = 0;
+    auto start = std::chrono::steady_clock::now();
+    const int count = sizeof(bench_positions) / sizeof(bench_positions[0]);
+    for (int i = 0; i < count; i++) {
+        GomokuBoard position;
+        std::istringstream moves(bench_positions[i]);
+        int x, y;
+        while (moves >> x >> y) {
+            position.put_disc(Point(x, y));
+        }
+        position.thisplayer = position.cur_player;
+        tt.clear();
+        ordering.clear();
+        search_stopped = false;
+        position.nodes = 0;
+        PVLine line;
+        int value = 0;
+        int scores[MAX_DEPTH + 1] = {};
+        for (int d = 1; d <= depth; d++) {
+            value = scores[d] = position.aspiration_search(d, d > 2, scores[d > 2 ? d - 2 : 0], line);
+        }
+        Point best = line.length > 0 ? line.moves[0] : Point(-1, -1);
+        std::cout << "position " << i + 1 << " nodes " << position.nodes << " score " << value
+                  << " move " << best.x << "," << best.y << std::endl;
+        total += position.nodes;
+        for (uint64_t v : {(uint64_t)position.nodes, (uint64_t)(uint32_t)value, (uint64_t)(best.x * SIZE + best.y)}) {
+            uint64_t state = signature ^ v;
+            signature = splitmix64(state);
+        }
+    }
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)signature);
+    std::cout << "positions " << count << " depth " << depth << "\n"
+              << "nodes " << total << "\n"
+              << "time " << ms << "ms\n"
+              << "nps " << (ms > 0 ? total * 1000 / ms : 0) << "\n"
+              << "signature " << hex << std::endl;
+    return 0;
+}
+
+// Protocol mode: the arbiter starts the player once and talks to it over
+// stdin/stdout, so the transposition table and the book stay loaded between
+// moves. One command per line:
+//   new          start a new game; answered "ready"
+//   play x y     a stone for the side to move, whichever player made it
+//   go ms [inc]  move for the side to move within ms, with inc the clock's
+//                increment if ms is the remaining clock; answered "move x y"
+//   quit
+int run_protocol() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+        if (command == "new") {
+            game.reset();
+            std::cout << "ready" << std::endl;
+        }
+        else if (command == "play") {
+            int x, y;
+            if (in >> x >> y) {
+                game.put_disc(Point(x, y));
+            }
+        }
+        else if (command == "go") {
+            int ms = TIMEOUT * 1000, inc;
+            in >> ms;
+            if (!(in >> inc)) {
+                inc = -1;
+            }
+            timer.start_move(ms, inc);
+            game.thisplayer = game.cur_player;
+            std::ostringstream moves;
+            game.next_step(moves);
+            std::cout << "move " << game.nextstep.x << " " << game.nextstep.y << std::endl;
+        }
+        else if (command == "quit") {
+            break;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const char* megabytes = getenv("GOMOKU_HASH_MB");
+    size_t table_megabytes = megabytes ? atoi(megabytes) : TT_MEGABYTES;
+    if (argc >= 2 && std::string(argv[1]) == "bench") {
+        tt.resize(table_megabytes);
+        return run_bench(argc > 2 ? atoi(argv[2]) : BENCH_DEPTH);
+    }
+    // attempt --build-book file [plies] [width] [ms per position]
+    if (argc >= 3 && std::string(argv[1]) == "--build-book") {
+        tt.resize(table_megabytes);
+        return build_book(argv[2], argc > 3 ? atoi(argv[3]) : 6, argc > 4 ? atoi(argv[4]) : 3,
+                          argc > 5 ? atoi(argv[5]) : 2000);
+    }
+    const char* book_file = getenv("GOMOKU_BOOK");
+    book.open(book_file ? book_file : BOOK_FILE);
+    if (argc >= 2 && std::string(argv[1]) == "--protocol") {
+        tt.resize(table_megabytes);
+        return run_protocol();
+    }
+    // attempt state action [ms [inc]], the move's time as in protocol mode.
+    if (argc >= 4) {
+        timer.set_limit(atoi(argv[3]), argc >= 5 ? atoi(argv[4]) : -1);
+    }
+    std::ofstream fout(argv[2]);
+    StateFile binary;
+    if (binary.open(argv[1])) {
+        game.read_binary(*binary.state());
+    }
+    else {
+        std::ifstream fin(argv[1]);
+        game.read_board(fin);
+        fin.close();
+    }
+    // The move's clock is already running: have a legal move in the action
+    // file before anything is allocated.
+    game.report_move(fout, game.fallback_move());
+    if (!megabytes) {
+        table_megabytes = std::min<size_t>(table_megabytes,
+                                           std::max(1, timer.hard_ms * TT_MEGABYTES_PER_SECOND / 1000));
+    }
+    tt.resize(table_megabytes);
+    game.next_step(fout);
+    // Done: the arbiter need not wait for the rest of the move's time.
+    fout << "final" << std::endl;
+    fout.close();
+    return 0;
+}
@@ -0,0 +1,188 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+// The game every program is built for: the board is BOARD_SIZE x BOARD_SIZE
+// and BOARD_WIN_LENGTH in a row wins. Players, engine and arbiter must all
+// be built with the same values (make BOARD_SIZE=19 BOARD_WIN_LENGTH=6).
+#ifndef BOARD_SIZE
+#define BOARD_SIZE 15
+#endif
+#ifndef BOARD_WIN_LENGTH
+#define BOARD_WIN_LENGTH 5
+#endif
+
+enum SPOT_STATE {
+    EMPTY = 0,
+    BLACK = 1,
+    WHITE = 2
+};
+
+struct Point {
+    int x, y;
+    Point() : Point(0, 0) {}
+    Point(float x, float y) : x(x), y(y) {}
+    bool operator==(const Point& rhs) const {
+        return x == rhs.x && y == rhs.y;
+    }
+    bool operator!=(const Point& rhs) const {
+        return !operator==(rhs);
+    }
+    Point operator+(const Point& rhs) const {
+        return Point(x + rhs.x, y + rhs.y);
+    }
+    Point operator-(const Point& rhs) const {
+        return Point(x - rhs.x, y - rhs.y);
+    }
+};
+
+// Board stored as one bit per cell and colour, kept in all four orientations
+// so that every line through a cell is a single word:
+//   HORIZONTAL     line x,           bit y
+//   VERTICAL       line y,           bit x
+//   DIAGONAL       line x-y+SIZE-1,  bit x   (cells (x+k, y+k))
+//   ANTI_DIAGONAL  line x+y,         bit x   (cells (x-k, y+k))
+// Placing a stone sets four bits, a five is a run test on four words.
+// Size and win length are template parameters, so every loop over the board
+// and the run test have compile-time bounds in each instantiation; the
+// programs use the BitBoard typedef below.
+
+// Bits that start a run of N set bits: N - 1 shift-and steps, unrolled.
+template <int N>
+struct Runs {
+    static uint32_t of(uint32_t l) {
+        return Runs<N - 1>::of(l) & (l >> (N - 1));
+    }
+};
+template <>
+struct Runs<1> {
+    static uint32_t of(uint32_t l) {
+        return l;
+    }
+};
+
+template <int Size, int WinLength>
+class BasicBitBoard {
+public:
+    typedef uint32_t Line;
+    enum DIRECTION {
+        HORIZONTAL = 0,
+        VERTICAL = 1,
+        DIAGONAL = 2,
+        ANTI_DIAGONAL = 3
+    };
+    static const int SIZE = Size;
+    static const int WIN_LENGTH = WinLength;
+    static const int DIAGONALS = 2 * SIZE - 1;
+    static const int LINES = 2 * SIZE + 2 * DIAGONALS;
+    static const Line FULL = (Line(1) << SIZE) - 1;
+    // The evaluator pads a line with a cell at each end.
+    static_assert(SIZE + 2 <= 32, "a line and its padding must fit in a Line");
+    static_assert(WIN_LENGTH >= 2 && WIN_LENGTH <= SIZE, "bad win length");
+
+    // stones[disc - 1][line]
+    Line stones[2][LINES];
+
+    BasicBitBoard() {
+        reset();
+    }
+    void reset() {
+        for (int c = 0; c < 2; c++)
+            for (int l = 0; l < LINES; l++)
+                stones[c][l] = 0;
+    }
+
+    static bool is_on_board(int x, int y) {
+        return 0 <= x && x < SIZE && 0 <= y && y < SIZE;
+    }
+    static int line_index(int dir, int x, int y) {
+        switch (dir) {
+            case HORIZONTAL:
+                return x;
+            case VERTICAL:
+                return SIZE + y;
+            case DIAGONAL:
+                return 2 * SIZE + x - y + SIZE - 1;
+            default:
+                return 2 * SIZE + DIAGONALS + x + y;
+        }
+    }
+    static int bit_index(int dir, int x, int y) {
+        return dir == HORIZONTAL ? y : x;
+    }
+    // Inverse of line_index/bit_index.
+    static Point cell_of(int line, int bit) {
+        if (line < SIZE)
+            return Point(line, bit);
+        if (line < 2 * SIZE)
+            return Point(bit, line - SIZE);
+        if (line < 2 * SIZE + DIAGONALS)
+            return Point(bit, bit - (line - 2 * SIZE - (SIZE - 1)));
+        return Point(bit, line - 2 * SIZE - DIAGONALS - bit);
+    }
+    // Cells of the line that lie on the board.
+    static Line line_mask(int line) {
+        if (line < 2 * SIZE)
+            return FULL;
+        int k;
+        if (line < 2 * SIZE + DIAGONALS) {
+            k = line - 2 * SIZE - (SIZE - 1);           // x - y
+            int lo = k > 0 ? k : 0;
+            int hi = k < 0 ? SIZE - 1 + k : SIZE - 1;
+            return (FULL >> (SIZE - 1 - hi)) & ~((Line(1) << lo) - 1);
+        }
+        k = line - 2 * SIZE - DIAGONALS;                // x + y
+        int lo = k - SIZE + 1 > 0 ? k - SIZE + 1 : 0;
+        int hi = k < SIZE - 1 ? k : SIZE - 1;
+        return (FULL >> (SIZE - 1 - hi)) & ~((Line(1) << lo) - 1);
+    }
+    // True if the word holds WIN_LENGTH or more consecutive set bits.
+    static bool has_win(Line l) {
+        return Runs<WIN_LENGTH>::of(l) != 0;
+    }
+
+    int get(int x, int y) const {
+        Line bit = Line(1) << y;
+        if (stones[0][x] & bit)
+            return BLACK;
+        if (stones[1][x] & bit)
+            return WHITE;
+        return EMPTY;
+    }
+    void place(int x, int y, int disc) {
+        Line* s = stones[disc - 1];
+        for (int dir = 0; dir < 4; dir++)
+            s[line_index(dir, x, y)] |= Line(1) << bit_index(dir, x, y);
+    }
+    void remove(int x, int y, int disc) {
+        Line* s = stones[disc - 1];
+        for (int dir = 0; dir < 4; dir++)
+            s[line_index(dir, x, y)] &= ~(Line(1) << bit_index(dir, x, y));
+    }
+    // Stones of one colour on the line through (x, y) in the given direction.
+    Line segment(int disc, int dir, int x, int y) const {
+        return stones[disc - 1][line_index(dir, x, y)];
+    }
+    Line occupied(int line) const {
+        return stones[0][line] | stones[1][line];
+    }
+    // WIN_LENGTH or more in a row (a five, in gomoku) through (x, y) for
+    // disc.
+    bool is_five(int x, int y, int disc) const {
+        return has_win(stones[disc - 1][line_index(HORIZONTAL, x, y)])
+            || has_win(stones[disc - 1][line_index(VERTICAL, x, y)])
+            || has_win(stones[disc - 1][line_index(DIAGONAL, x, y)])
+            || has_win(stones[disc - 1][line_index(ANTI_DIAGONAL, x, y)]);
+    }
+    int count(int disc) const {
+        int n = 0;
+        for (int x = 0; x < SIZE; x++)
+            n += __builtin_popcount(stones[disc - 1][x]);
+        return n;
+    }
+};
+
+typedef BasicBitBoard<BOARD_SIZE, BOARD_WIN_LENGTH> BitBoard;
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "bitboard.h"
+#include "zobrist.h"
+#include "mapped_file.h"
+
+// Opening book: a header followed by entries sorted by the Zobrist key of
+// the position, so a lookup is a binary search straight over the file. The
+// file is mapped read-only rather than read, so opening it costs nothing and
+// only the pages a lookup touches are ever loaded. Integers are stored in
+// native (little-endian) order.
+//
+// Side to move is implied by the stone count and is not part of the key.
+// The builder writes every position in all eight orientations of the board,
+// so a lookup never has to transform the position.
+
+const char BOOK_MAGIC[8] = {'G', 'M', 'K', 'B', 'O', 'O', 'K', '2'};
+
+// The game the book was built for; a book is only used by an engine built
+// for the same board size and win length. The size keeps the entries
+// 8-byte aligned.
+struct BookHeader {
+    char magic[8];
+    uint32_t board_size;
+    uint32_t win_length;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct BookEntry {
+    uint64_t key;
+    uint16_t move;      // x * SIZE + y
+    uint16_t ply;       // stones on the board
+    uint32_t reserved;
+
+    bool operator<(const BookEntry& rhs) const {
+        return key < rhs.key;
+    }
+};
+
+// The eight rotations and reflections of the board.
+inline Point book_transform(Point p, int symmetry) {
+    const int last = BitBoard::SIZE - 1;
+    int x = p.x, y = p.y;
+    if (symmetry & 1)
+        x = last - x;
+    if (symmetry & 2)
+        y = last - y;
+    if (symmetry & 4)
+        std::swap(x, y);
+    return Point(x, y);
+}
+
+inline uint64_t book_hash(const BitBoard& board, int symmetry) {
+    uint64_t key = 0;
+    for (int x = 0; x < BitBoard::SIZE; x++) {
+        for (int y = 0; y < BitBoard::SIZE; y++) {
+            if (board.get(x, y) != EMPTY) {
+                Point t = book_transform(Point(x, y), symmetry);
+                key ^= zobrist_key(t.x, t.y, board.get(x, y));
+            }
+        }
+    }
+    return key;
+}
+
+class OpeningBook {
+public:
+    OpeningBook() : entries(nullptr), count(0) {}
+
+    // False if the file is missing or not a book for this game.
+    bool open(const char* path) {
+        close();
+        if (!file.open(path))
+            return false;
+        const BookHeader* header = reinterpret_cast<const BookHeader*>(file.data());
+        if (file.size() < sizeof(BookHeader) || memcmp(header->magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0
+            || header->board_size != BitBoard::SIZE || header->win_length != BitBoard::WIN_LENGTH
+            || file.size() < sizeof(BookHeader) + (size_t)header->count * sizeof(BookEntry)) {
+            close();
+            return false;
+        }
+        entries = reinterpret_cast<const BookEntry*>(file.data() + sizeof(BookHeader));
+        count = header->count;
+        return true;
+    }
+    void close() {
+        file.close();
+        entries = nullptr;
+        count = 0;
+    }
+    size_t size() const {
+        return count;
+    }
+
+    bool lookup(uint64_t key, Point& move) const {
+        BookEntry probe = BookEntry();
+        probe.key = key;
+        const BookEntry* e = std::lower_bound(entries, entries + count, probe);
+        if (e == entries + count || e->key != key)
+            return false;
+        move = Point(e->move / BitBoard::SIZE, e->move % BitBoard::SIZE);
+        return true;
+    }
+
+    // Sorts the entries, keeps the first entry of each key and writes the
+    // file.
+    static bool write(const char* path, std::vector<BookEntry>& list) {
+        std::stable_sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end(),
+            [](const BookEntry& a, const BookEntry& b) { return a.key == b.key; }), list.end());
+        BookHeader header = BookHeader();
+        memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+        header.board_size = BitBoard::SIZE;
+        header.win_length = BitBoard::WIN_LENGTH;
+        header.count = (uint32_t)list.size();
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(list.data()), list.size() * sizeof(BookEntry));
+        return (bool)out;
+    }
+
+private:
+    MappedFile file;
+    const BookEntry* entries;
+    size_t count;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "bitboard.h"
+#include "patterns.h"
+
+// x86 builds with GCC or Clang also get an AVX2 kernel for scoring the whole
+// board, used when the CPU has AVX2. -DEVAL_NO_SIMD leaves it out.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(EVAL_NO_SIMD)
+#define EVAL_AVX2
+#include <immintrin.h>
+#endif
+
+// Line-by-line static evaluation kept in step with a BitBoard. Every line
+// holds its score for both colours; after a stone is placed or removed only
+// the four lines through that cell are rescored, so reading the evaluation
+// of a position is O(1). Templated on the board type; the programs use the
+// Evaluator typedef.
+template <class Board>
+class BasicEvaluator {
+public:
+    typedef typename Board::Line Line;
+    typedef PatternTable<Board::WIN_LENGTH> Table;
+    static const int FIVE = PATTERN_FIVE;
+    static const int WINDOWS = Board::SIZE + 3 - Table::CELLS;
+
+    int line_score[2][Board::LINES];
+    int total[2];
+
+    BasicEvaluator() {
+        for (int c = 0; c < 2; c++) {
+            for (int l = 0; l < Board::LINES; l++)
+                line_score[c][l] = 0;
+            total[c] = 0;
+        }
+    }
+
+    // Score of one line for the owner of `own`, summed over every window of
+    // WIN_LENGTH + 1 cells from one cell before the line to one cell past it,
+    // so shapes touching the edge are seen as closed.
+    static int score_line(Line own, Line opp, Line mask) {
+        if (!own)
+            return 0;
+        Line o = own << 1;
+        Line b = ((opp | ~mask) << 1) | 1;
+        int value = 0;
+        for (int p = 0; p < WINDOWS; p++)
+            value += table().score[((o >> p) & Table::MASK) | (((b >> p) & Table::MASK) << Table::CELLS)];
+        return value;
+    }
+    static int score_line(const Board& board, int disc, int line) {
+        return score_line(board.stones[disc - 1][line], board.stones[2 - disc][line], Board::line_mask(line));
+    }
+    // Scores of every line for disc, out[line], recomputed from scratch.
+    static void score_lines(const Board& board, int disc, int* out) {
+#ifdef EVAL_AVX2
+        if (has_avx2()) {
+            score_lines_avx2(board, disc, out);
+            return;
+        }
+#endif
+        for (int l = 0; l < Board::LINES; l++)
+            out[l] = score_line(board, disc, l);
+    }
+
+    void reset(const Board& board) {
+        for (int c = 0; c < 2; c++) {
+            score_lines(board, c + 1, line_score[c]);
+            total[c] = 0;
+            for (int l = 0; l < Board::LINES; l++)
+                total[c] += line_score[c][l];
+        }
+    }
+    // Call after a stone at (x, y) has been placed on or removed from board.
+    void update(const Board& board, int x, int y) {
+        for (int dir = 0; dir < 4; dir++) {
+            int l = Board::line_index(dir, x, y);
+            for (int c = 0; c < 2; c++) {
+                int s = score_line(board, c + 1, l);
+                total[c] += s - line_score[c][l];
+                line_score[c][l] = s;
+            }
+        }
+    }
+    // The lines update() rescores and the scores it replaces, so that a
+    // move can be taken back without rescoring.
+    struct Undo {
+        int line[4];
+        int line_score[2][4];
+        int total[2];
+    };
+    // update() that also saves what it replaces in undo.
+    void update(const Board& board, int x, int y, Undo& undo) {
+        undo.total[0] = total[0];
+        undo.total[1] = total[1];
+        for (int dir = 0; dir < 4; dir++) {
+            int l = Board::line_index(dir, x, y);
+            undo.line[dir] = l;
+            for (int c = 0; c < 2; c++) {
+                int s = score_line(board, c + 1, l);
+                undo.line_score[c][dir] = line_score[c][l];
+                total[c] += s - line_score[c][l];
+                line_score[c][l] = s;
+            }
+        }
+    }
+    // Takes back update(board, x, y, undo).
+    void restore(const Undo& undo) {
+        for (int c = 0; c < 2; c++) {
+            total[c] = undo.total[c];
+            for (int dir = 0; dir < 4; dir++)
+                line_score[c][undo.line[dir]] = undo.line_score[c][dir];
+        }
+    }
+    // Evaluation from the point of view of disc.
+    int score(int disc) const {
+        return total[disc - 1] - total[2 - disc];
+    }
+
+private:
+    static const Table& table() {
+        return Patterns<Board::WIN_LENGTH>::table;
+    }
+
+    // The lines that can hold WIN_LENGTH cells: every row and column and the
+    // longer diagonals, 72 on 15x15. A shorter line has a blocked cell in
+    // every span and always scores 0.
+    struct ScoredLines {
+        int count;
+        int index[Board::LINES];
+        Line mask[Board::LINES];
+
+        ScoredLines() : count(0) {
+            for (int l = 0; l < Board::LINES; l++) {
+                if (__builtin_popcount(Board::line_mask(l)) >= Board::WIN_LENGTH) {
+                    index[count] = l;
+                    mask[count] = Board::line_mask(l);
+                    count++;
+                }
+            }
+        }
+    };
+    static const ScoredLines& scored_lines() {
+        static const ScoredLines lines;
+        return lines;
+    }
+
+#ifdef EVAL_AVX2
+    static bool has_avx2() {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+    // score_line for eight lines at a time, one per 32-bit lane: the lines'
+    // words are gathered from the board, every window is cut out of them
+    // with shifts and masks, and its score gathered from the pattern table.
+    // Sums as the scalar code does, so the scores are the same.
+    __attribute__((target("avx2")))
+    static void score_lines_avx2(const Board& board, int disc, int* out) {
+        const ScoredLines& lines = scored_lines();
+        const int* own_words = reinterpret_cast<const int*>(board.stones[disc - 1]);
+        const int* opp_words = reinterpret_cast<const int*>(board.stones[2 - disc]);
+        const __m256i window = _mm256_set1_epi32(Table::MASK);
+        const __m256i ones = _mm256_set1_epi32(-1);
+        const __m256i edge = _mm256_set1_epi32(1);
+        for (int l = 0; l < Board::LINES; l++)
+            out[l] = 0;
+        int n = 0;
+        for (; n + 8 <= lines.count; n += 8) {
+            __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lines.index + n));
+            __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lines.mask + n));
+            __m256i own = _mm256_i32gather_epi32(own_words, index, 4);
+            __m256i opp = _mm256_i32gather_epi32(opp_words, index, 4);
+            __m256i o = _mm256_slli_epi32(own, 1);
+            __m256i b = _mm256_or_si256(_mm256_slli_epi32(_mm256_or_si256(opp, _mm256_xor_si256(mask, ones)), 1), edge);
+            __m256i sum = _mm256_setzero_si256();
+            for (int p = 0; p < WINDOWS; p++) {
+                __m256i cells = _mm256_or_si256(_mm256_and_si256(o, window),
+                                                _mm256_slli_epi32(_mm256_and_si256(b, window), Table::CELLS));
+                sum = _mm256_add_epi32(sum, _mm256_i32gather_epi32(table().score, cells, 4));
+                o = _mm256_srli_epi32(o, 1);
+                b = _mm256_srli_epi32(b, 1);
+            }
+            int scores[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(scores), sum);
+            for (int i = 0; i < 8; i++)
+                out[lines.index[n + i]] = scores[i];
+        }
+        for (; n < lines.count; n++)
+            out[lines.index[n]] = score_line(board, disc, lines.index[n]);
+    }
+#endif
+};
+
+typedef BasicEvaluator<BitBoard> Evaluator;
+
+#endif
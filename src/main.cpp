@@ -1,276 +1,859 @@
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <sstream>
-#include <array>
-#include <vector>
-#include <cassert>
-
-#define TIMEOUT 10
-
-struct Point {
-    int x, y;
-	Point() : Point(0, 0) {}
-	Point(float x, float y) : x(x), y(y) {}
-	bool operator==(const Point& rhs) const {
-		return x == rhs.x && y == rhs.y;
-	}
-	bool operator!=(const Point& rhs) const {
-		return !operator==(rhs);
-	}
-	Point operator+(const Point& rhs) const {
-		return Point(x + rhs.x, y + rhs.y);
-	}
-	Point operator-(const Point& rhs) const {
-		return Point(x - rhs.x, y - rhs.y);
-	}
-};
-
-class GomokuBoard {
-public:
-    enum SPOT_STATE {
-        EMPTY = 0,
-        BLACK = 1,
-        WHITE = 2
-    };
-    static const int SIZE = 15;
-    std::array<std::array<int, SIZE>, SIZE> board;
-    int empty_count;
-    int cur_player;
-    bool done;
-    int winner;
-private:
-    int get_next_player(int player) const {
-        return 3 - player;
-    }
-    bool is_spot_on_board(Point p) const {
-        return 0 <= p.x && p.x < SIZE && 0 <= p.y && p.y < SIZE;
-    }
-    int get_disc(Point p) const {
-        return board[p.x][p.y];
-    }
-    void set_disc(Point p, int disc) {
-        board[p.x][p.y] = disc;
-    }
-    bool is_disc_at(Point p, int disc) const {
-        if (!is_spot_on_board(p))
-            return false;
-        if (get_disc(p) != disc)
-            return false;
-        return true;
-    }
-    bool is_spot_valid(Point center) const {
-        if (get_disc(center) != EMPTY)
-            return false;
-        return true;
-    }
-    
-public:
-    GomokuBoard() {
-        reset();
-    }
-    void reset() {
-        for (int i = 0; i < SIZE; i++) {
-            for (int j = 0; j < SIZE; j++) {
-                board[i][j] = EMPTY;
-            }
-        }
-        cur_player = BLACK;
-        empty_count = SIZE*SIZE;
-        done = false;
-        winner = -1;
-    }
-    bool put_disc(Point p) {
-        if(!is_spot_valid(p)) {
-            winner = get_next_player(cur_player);
-            done = true;
-            return false;
-        }
-        set_disc(p, cur_player);
-        empty_count--;
-        // Check Win
-        if (checkwin(cur_player)) {
-            done = true;
-            winner = cur_player;
-        }
-        if (empty_count == 0) {
-            done = true;
-            winner = EMPTY;
-        }
-
-        // Give control to the other player.
-        cur_player = get_next_player(cur_player);
-        return true;
-    }
-    bool checkwin(int disc){
-        for (int i = 0; i < SIZE; i++) {
-            for (int j = 0; j < SIZE; j++) {
-                if (is_disc_at(Point(i, j), disc)){
-                    bool iswin = true;
-                    if (i + 4 < SIZE) {                                 //HORIZONTAL
-                        for(int k = 0; k < 5; k++)                              
-                            if (!is_disc_at(Point(i+k, j), disc)) {
-                                iswin = false;
-                                break;
-                            }
-                        if (iswin) return true;
-                    }
-                    iswin = true;
-                    if (j + 4 < SIZE) {                                 //VERTICAL
-                        for(int k = 0; k < 5; k++)
-                            if (!is_disc_at(Point(i, j+k), disc)) {
-                                iswin = false;
-                                break;
-                            }
-                        if (iswin) return true;
-                    }
-                    iswin = true;
-                    if (i + 4 < SIZE && j + 4 < SIZE) {                 //DIAGONAL TO RIGHT
-                        for(int k = 0; k < 5; k++)
-                            if (!is_disc_at(Point(i+k, j+k), disc)) {
-                                iswin = false;
-                                break;
-                            }
-                        if (iswin) return true;
-                    }
-                    iswin = true;
-                    if (i - 4 >= 0 && j + 4 < SIZE) {                   //DIAGONAL TO LEFT
-                        for(int k = 0; k < 5; k++)
-                            if (!is_disc_at(Point(i-k, j+k), disc)) {
-                                iswin = false;
-                                break;
-                            }
-                        if (iswin) return true;
-                    }
-                }
-            }
-        }
-        return false;
-    }
-    std::string encode_player(int state) {
-        if (state == BLACK) return "O";
-        if (state == WHITE) return "X";
-        return "Draw";
-    }
-    std::string encode_spot(int x, int y) {
-        if (is_spot_valid(Point(x, y))) return ".";
-        if (board[x][y] == BLACK) return "O";
-        if (board[x][y] == WHITE) return "X";
-        return " ";
-    }
-    std::string encode_output(bool fail=false) {
-        int i, j;
-        std::stringstream ss;
-        ss << "Timestep #" << (SIZE*SIZE-empty_count+1) << "\n";
-        if (fail) {
-            ss << "Winner is " << encode_player(winner) << " (Opponent performed invalid move)\n";
-        } else if (done) {
-            ss << "Winner is " << encode_player(winner) << "\n";
-        } else {
-            ss << encode_player(cur_player) << "'s turn\n";
-        }
-        ss << "+-----------------------------+\n";
-        for (i = 0; i < SIZE; i++) {
-            ss << "|";
-            for (j = 0; j < SIZE-1; j++) {
-                ss << encode_spot(i, j) << " ";
-            }
-            ss << encode_spot(i, j) << "|\n";
-        }
-        ss << "===============================\n";
-        return ss.str();
-    }
-    std::string encode_state() {
-        int i, j;
-        std::stringstream ss;
-        ss << cur_player << "\n";
-        for (i = 0; i < SIZE; i++) {
-            for (j = 0; j < SIZE-1; j++) {
-                ss << board[i][j] << " ";
-            }
-            ss << board[i][j] << "\n";
-        }
-        return ss.str();
-    }
-};
-
-const std::string file_log = "gamelog.txt";
-const std::string file_state = "state";
-const std::string file_action = "action";
-const int timeout = TIMEOUT;
-
-void launch_executable(std::string filename) {
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
-    size_t pos;
-    std::string command = "start /min " + filename + " " + file_state + " " + file_action;
-    if((pos = filename.rfind("/"))!=std::string::npos || (pos = filename.rfind("\\"))!=std::string::npos)
-        filename = filename.substr(pos+1, std::string::npos);
-    std::string kill = "timeout /t " + std::to_string(timeout) + " > NUL && taskkill /im " + filename + " > NUL 2>&1";
-    system(command.c_str());
-    system(kill.c_str());
-#elif __linux__
-    std::string command = "timeout " + std::to_string(timeout) + "s " + filename + " " + file_state + " " + file_action;
-    system(command.c_str());
-#elif __APPLE__
-    // May require installing the command by:
-    // brew install coreutils
-    std::string command = "gtimeout " + std::to_string(timeout) + "s " + filename + " " + file_state + " " + file_action;
-    system(command.c_str());
-#endif
-}
-
-int main(int argc, char** argv) {
-    assert(argc == 3);
-    std::ofstream log("gamelog.txt");
-    std::string player_filename[3];
-    player_filename[1] = argv[1];
-    player_filename[2] = argv[2];
-    std::cout << "Player Black File: " << player_filename[GomokuBoard::BLACK] << std::endl;
-    std::cout << "Player White File: " << player_filename[GomokuBoard::WHITE] << std::endl;
-    GomokuBoard game;
-    std::string data;
-    data = game.encode_output();
-    std::cout << data;
-    log << data;
-    while (!game.done) {
-        // Output current state
-        data = game.encode_state();
-        std::ofstream fout(file_state);
-        fout << data;
-        fout.close();
-        // Run external program
-        launch_executable(player_filename[game.cur_player]);
-        // Read action
-        std::ifstream fin(file_action);
-        Point p(-1, -1);
-        while (true) {
-            int x, y;
-            if (!(fin >> x)) {
-                break;
-            }
-            if (!(fin >> y)) break;
-            p.x = x; p.y = y;
-        }
-        fin.close();
-        std::cout << "Put: (" << p.x << ',' << p.y << ")\n";
-        // Reset action file
-        if (remove(file_action.c_str()) != 0)
-            std::cerr << "Error removing file: " << file_action << "\n";
-        // Take action
-        if (!game.put_disc(p)) {
-            // If action is invalid.
-            data = game.encode_output(true);
-            std::cout << data;
-            log << data;
-            break;
-        }
-        data = game.encode_output();
-        std::cout << data;
-        log << data;
-    }
-    log.close();
-    // Reset state file
-    if (remove(file_state.c_str()) != 0)
-        std::cerr << "Error removing file: " << file_state << "\n";
-    return 0;
-}
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <array>
+#include <vector>
+#include <cassert>
+#include <chrono>
+#include <cctype>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <csignal>
+
+#include "platform.h"
+#ifdef GOMOKU_POSIX
+#include <climits>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "bitboard.h"
+#include "state_format.h"
+#include "record.h"
+#include "metrics.h"
+
+#define TIMEOUT 10
+// How long past a protocol player's deadline the arbiter still waits for
+// its reply, so a move sent in time is not lost to pipe and scheduling
+// latency. Under a clock the move still has to be within the time left.
+#define PROTOCOL_GRACE_MS 200
+
+class GomokuBoard {
+public:
+    static const int SIZE = BitBoard::SIZE;
+    BitBoard board;
+    int empty_count;
+    int cur_player;
+    bool done;
+    int winner;
+    BinaryState record;     // the game so far, in binary state form
+private:
+    int get_next_player(int player) const {
+        return 3 - player;
+    }
+    bool is_spot_on_board(Point p) const {
+        return 0 <= p.x && p.x < SIZE && 0 <= p.y && p.y < SIZE;
+    }
+    int get_disc(Point p) const {
+        return board.get(p.x, p.y);
+    }
+    void set_disc(Point p, int disc) {
+        board.place(p.x, p.y, disc);
+    }
+    bool is_disc_at(Point p, int disc) const {
+        if (!is_spot_on_board(p))
+            return false;
+        if (get_disc(p) != disc)
+            return false;
+        return true;
+    }
+    bool is_spot_valid(Point center) const {
+        if (!is_spot_on_board(center))
+            return false;
+        if (get_disc(center) != EMPTY)
+            return false;
+        return true;
+    }
+    
+public:
+    GomokuBoard() {
+        reset();
+    }
+    void reset() {
+        board.reset();
+        cur_player = BLACK;
+        empty_count = SIZE*SIZE;
+        done = false;
+        winner = -1;
+        record.clear(BLACK);
+    }
+    bool put_disc(Point p) {
+        if(!is_spot_valid(p)) {
+            winner = get_next_player(cur_player);
+            done = true;
+            return false;
+        }
+        set_disc(p, cur_player);
+        record.play(p.x, p.y, cur_player);
+        record.to_move = get_next_player(cur_player);
+        empty_count--;
+        // Check Win: only the four lines through the new stone can have changed.
+        if (board.is_five(p.x, p.y, cur_player)) {
+            done = true;
+            winner = cur_player;
+        }
+        if (empty_count == 0) {
+            done = true;
+            winner = EMPTY;
+        }
+
+        // Give control to the other player.
+        cur_player = get_next_player(cur_player);
+        return true;
+    }
+    std::string encode_player(int state) {
+        if (state == BLACK) return "O";
+        if (state == WHITE) return "X";
+        return "Draw";
+    }
+    // fail: the last move lost, for reason ("timeout", "error" or empty for
+    // an invalid move) as in the record's result line.
+    std::string encode_output(bool fail=false, const std::string& reason="") {
+        std::string status;
+        if (fail) {
+            status = "Winner is " + encode_player(winner) + " (" + forfeit_text(reason) + ")";
+        } else if (done) {
+            status = "Winner is " + encode_player(winner);
+        } else {
+            status = encode_player(cur_player) + "'s turn";
+        }
+        std::string out;
+        render_board(out, board, SIZE*SIZE-empty_count+1, status);
+        return out;
+    }
+    std::string encode_state() {
+        int i, j;
+        std::stringstream ss;
+        ss << cur_player << "\n";
+        for (i = 0; i < SIZE; i++) {
+            for (j = 0; j < SIZE-1; j++) {
+                ss << board.get(i, j) << " ";
+            }
+            ss << board.get(i, j) << "\n";
+        }
+        return ss.str();
+    }
+};
+
+const std::string file_log = "gamelog.txt";
+const std::string file_state = "state";
+const std::string file_action = "action";
+const std::string file_metrics = "metrics.txt";
+const int timeout = TIMEOUT;
+
+// Path of a per-game file; dir is empty for the current directory.
+std::string in_dir(const std::string& dir, const std::string& name) {
+    return dir.empty() ? name : dir + "/" + name;
+}
+
+// Time control of a game. Every move must be made within move_ms; with a
+// Fischer clock (base_ms > 0) a player also has base_ms for the whole game
+// plus inc_ms for every move it makes. A player out of clock has no move,
+// which loses like an invalid one. Unless set, move_ms is TIMEOUT without a
+// clock and unlimited with one.
+struct TimeControl {
+    int move_ms = -1;
+    int base_ms = 0;
+    int inc_ms = 0;
+
+    // The per-move limit in ms, 0 for none.
+    int move_limit() const {
+        return move_ms >= 0 ? move_ms : base_ms > 0 ? 0 : timeout * 1000;
+    }
+    // Reads "-t ms" or "--clock base+inc" at argv[i] and moves i to its
+    // value. False if argv[i] is neither, or its value is bad.
+    bool option(int argc, char** argv, int& i) {
+        std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc) {
+            move_ms = atoi(argv[++i]);
+            return move_ms > 0;
+        }
+        if (arg == "--clock" && i + 1 < argc)
+            return parse_clock(argv[++i]);
+        return false;
+    }
+
+    // The clock as "base+inc" in milliseconds, e.g. "60000+500".
+    bool parse_clock(const std::string& spec) {
+        char plus;
+        std::istringstream in(spec);
+        if (!(in >> base_ms) || base_ms <= 0)
+            return false;
+        inc_ms = 0;
+        if (in >> plus && (plus != '+' || !(in >> inc_ms) || inc_ms < 0))
+            return false;
+        return true;
+    }
+};
+
+#ifdef GOMOKU_POSIX
+// True if the action file has grown since size and now ends with the line
+// "final", the marker of a player that has made its move and needs no more
+// time.
+bool action_final(const std::string& path, off_t& size) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || st.st_size == size)
+        return false;
+    size = st.st_size;
+    std::ifstream in(path, std::ios::binary);
+    char tail[16] = {};
+    off_t from = size > (off_t)sizeof(tail) - 1 ? size - (off_t)sizeof(tail) + 1 : 0;
+    in.seekg(from);
+    in.read(tail, sizeof(tail) - 1);
+    std::string last(tail, (size_t)in.gcount());
+    while (!last.empty() && isspace((unsigned char)last.back()))
+        last.pop_back();
+    size_t eol = last.find_last_of("\r\n");
+    return last.substr(eol == std::string::npos ? 0 : eol + 1) == "final";
+}
+#endif
+
+// Runs a file-protocol player for one move and returns what it used. The
+// player gets "state action ms [inc]": the time it has for the move, and
+// when that is its whole remaining clock the increment, so it can budget
+// what is left; a per-move limit shorter than the clock comes without one.
+// It is stopped when it exits, when it ends the action file with "final",
+// or after ms. dir is the game's directory (empty for the current one); the
+// player runs there and is given the state and action files by their plain
+// names.
+MoveMetrics launch_executable(std::string filename, const std::string& dir, int move_ms, int inc_ms = -1) {
+    MoveMetrics metrics;
+    auto start = std::chrono::steady_clock::now();
+    std::string ms = std::to_string(move_ms);
+    std::string inc = std::to_string(inc_ms);
+#ifndef GOMOKU_POSIX
+    // Windows waits whole seconds and does not watch for "final". It always
+    // plays in the current directory: tournaments, the only games with a
+    // directory of their own, are POSIX-only.
+    (void)dir;
+    size_t pos;
+    std::string command = "start /min " + filename + " " + file_state + " " + file_action + " " + ms + (inc_ms >= 0 ? " " + inc : "");
+    if((pos = filename.rfind("/"))!=std::string::npos || (pos = filename.rfind("\\"))!=std::string::npos)
+        filename = filename.substr(pos+1, std::string::npos);
+    std::string kill = "timeout /t " + std::to_string((move_ms + 999) / 1000) + " > NUL && taskkill /im " + filename + " > NUL 2>&1";
+    system(command.c_str());
+    system(kill.c_str());
+#else
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Error starting player: " << filename << "\n";
+        return metrics;
+    }
+    if (pid == 0) {
+        if (!dir.empty() && chdir(dir.c_str()) != 0)
+            _exit(127);
+        execlp(filename.c_str(), filename.c_str(), file_state.c_str(), file_action.c_str(), ms.c_str(),
+               inc_ms >= 0 ? inc.c_str() : (char*)nullptr, (char*)nullptr);
+        _exit(127);
+    }
+    // wait4 reaps the player and gives its own CPU time and peak RSS. It is
+    // polled rather than blocked on so the deadline and the action file can
+    // be watched.
+    auto deadline = start + std::chrono::milliseconds(move_ms);
+    std::string action = in_dir(dir, file_action);
+    off_t action_size = 0;
+    struct rusage usage;
+    int status;
+    pid_t reaped;
+    while ((reaped = wait4(pid, &status, WNOHANG, &usage)) == 0) {
+        bool expired = std::chrono::steady_clock::now() >= deadline;
+        if (expired || action_final(action, action_size)) {
+            kill(pid, SIGKILL);
+            reaped = wait4(pid, &status, 0, &usage);
+            metrics.timed_out = expired;
+            break;
+        }
+        usleep(1000);
+    }
+    if (reaped == pid)
+        metrics.set_usage(usage);
+#endif
+    metrics.wall_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    return metrics;
+}
+
+#ifdef GOMOKU_POSIX
+// A player started once for the whole game and driven over pipes
+// (--protocol). Commands and replies are lines:
+//   arbiter -> player   new | play x y | go <ms> [<inc>] | quit
+//   player -> arbiter   ready (after new) | move x y (after go)
+// go gives the time for the move and, when that is the remaining clock, the
+// increment, as the file mode's arguments do. Other output is ignored. The move clock only starts at "go", so startup
+// and the reply to "new" are not timed against a move; the player's stderr
+// is left attached to ours.
+class PlayerProcess {
+public:
+    PlayerProcess() : pid(-1), to_player(-1), from_player(-1) {}
+    ~PlayerProcess() {
+        stop();
+    }
+
+    // Starts the player with dir (if not empty) as its working directory.
+    bool start(const std::string& filename, const std::string& dir = "") {
+        // Games started concurrently must not leak their pipes into each
+        // other's players, or a player would never see end of input.
+        static std::mutex spawn;
+        std::lock_guard<std::mutex> lock(spawn);
+        int in[2], out[2];
+        if (pipe(in) != 0)
+            return false;
+        if (pipe(out) != 0) {
+            close(in[0]);
+            close(in[1]);
+            return false;
+        }
+        for (int fd : {in[0], in[1], out[0], out[1]})
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        pid = fork();
+        if (pid < 0) {
+            for (int fd : {in[0], in[1], out[0], out[1]})
+                close(fd);
+            return false;
+        }
+        if (pid == 0) {
+            if (!dir.empty() && chdir(dir.c_str()) != 0)
+                _exit(127);
+            dup2(in[0], STDIN_FILENO);
+            dup2(out[1], STDOUT_FILENO);
+            close(in[0]);
+            close(in[1]);
+            close(out[0]);
+            close(out[1]);
+            execlp(filename.c_str(), filename.c_str(), "--protocol", (char*)nullptr);
+            _exit(127);
+        }
+        close(in[0]);
+        close(out[1]);
+        to_player = in[1];
+        from_player = out[0];
+        return true;
+    }
+    bool send(const std::string& line) {
+        std::string data = line + "\n";
+        return write(to_player, data.data(), data.size()) == (ssize_t)data.size();
+    }
+    enum REPLY {
+        REPLY_OK,
+        REPLY_TIMEOUT,
+        REPLY_ERROR     // the player exited, or its reply could not be read
+    };
+    // Waits up to timeout_ms for a line starting with word and returns the
+    // rest of it in args; other lines are skipped.
+    REPLY read_reply(const std::string& word, int timeout_ms, std::string& args) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true) {
+            size_t eol;
+            while ((eol = buffer.find('\n')) != std::string::npos) {
+                std::string line = buffer.substr(0, eol);
+                buffer.erase(0, eol + 1);
+                if (line.compare(0, word.size(), word) == 0 && (line.size() == word.size() || isspace((unsigned char)line[word.size()]))) {
+                    args = line.substr(word.size());
+                    return REPLY_OK;
+                }
+            }
+            int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0)
+                return REPLY_TIMEOUT;
+            struct pollfd fd = {from_player, POLLIN, 0};
+            if (poll(&fd, 1, left) <= 0)
+                continue;
+            char chunk[4096];
+            ssize_t n = read(from_player, chunk, sizeof(chunk));
+            if (n <= 0)
+                return REPLY_ERROR;
+            buffer.append(chunk, n);
+        }
+    }
+    REPLY read_move(int timeout_ms, Point& p) {
+        std::string args;
+        REPLY reply = read_reply("move", timeout_ms, args);
+        if (reply != REPLY_OK)
+            return reply;
+        std::istringstream in(args);
+        int x, y;
+        if (!(in >> x >> y))
+            return REPLY_ERROR;
+        p = Point(x, y);
+        return REPLY_OK;
+    }
+    // Asks the player to quit, and kills it if it has not after a second.
+    // Returns the CPU time and peak RSS of its whole run.
+    MoveMetrics stop() {
+        MoveMetrics metrics;
+        if (pid <= 0)
+            return metrics;
+        send("quit");
+        close(to_player);
+        close(from_player);
+        struct rusage usage;
+        int status;
+        pid_t reaped = 0;
+        for (int i = 0; i < 100 && (reaped = wait4(pid, &status, WNOHANG, &usage)) == 0; i++)
+            usleep(10000);
+        if (reaped == 0) {
+            kill(pid, SIGKILL);
+            reaped = wait4(pid, &status, 0, &usage);
+        }
+        if (reaped == pid)
+            metrics.set_usage(usage);
+        pid = -1;
+        return metrics;
+    }
+
+private:
+    pid_t pid;
+    int to_player;
+    int from_player;
+    std::string buffer;
+};
+#endif
+
+// Replays game records and checks every move is legal and no move follows
+// the end of the game. A record is one game per line as "x y x y ...";
+// empty lines and lines starting with '#' are skipped.
+int verify_records(const std::string& filename) {
+    std::ifstream fin(filename, std::ios::binary);
+    if (!fin) {
+        std::cerr << "Error opening file: " << filename << "\n";
+        return 1;
+    }
+    std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    fin.close();
+    auto start = std::chrono::steady_clock::now();
+    long long games = 0, moves = 0, bad = 0;
+    long long results[3] = {0, 0, 0};
+    long long unfinished = 0;
+    GomokuBoard game;
+    const char* c = text.c_str();
+    const char* end = c + text.size();
+    while (c < end) {
+        const char* eol = c;
+        while (eol < end && *eol != '\n')
+            eol++;
+        while (c < eol && isspace((unsigned char)*c))
+            c++;
+        if (c == eol || *c == '#') {
+            c = eol + 1;
+            continue;
+        }
+        games++;
+        game.reset();
+        int values[2], count = 0, ply = 0;
+        bool ok = true;
+        while (c < eol) {
+            if (isspace((unsigned char)*c)) {
+                c++;
+                continue;
+            }
+            bool neg = *c == '-';
+            if (neg)
+                c++;
+            int v = 0;
+            while (c < eol && isdigit((unsigned char)*c))
+                v = v * 10 + (*c++ - '0');
+            values[count++] = neg ? -v : v;
+            if (c < eol && !isspace((unsigned char)*c)) {
+                std::cout << "Game " << games << ": malformed record\n";
+                ok = false;
+                break;
+            }
+            if (count < 2)
+                continue;
+            count = 0;
+            ply++;
+            Point p(values[0], values[1]);
+            if (game.done) {
+                std::cout << "Game " << games << ": move " << ply << " (" << p.x << ',' << p.y << ") after game end\n";
+                ok = false;
+                break;
+            }
+            if (!game.put_disc(p)) {
+                std::cout << "Game " << games << ": move " << ply << " (" << p.x << ',' << p.y << ") is invalid\n";
+                ok = false;
+                break;
+            }
+        }
+        if (ok && count != 0) {
+            std::cout << "Game " << games << ": malformed record\n";
+            ok = false;
+        }
+        moves += ply;
+        if (!ok)
+            bad++;
+        else if (game.done)
+            results[game.winner]++;
+        else
+            unfinished++;
+        c = eol + 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Games: " << games << " (O " << results[BLACK]
+              << ", X " << results[WHITE] << ", Draw " << results[EMPTY]
+              << ", unfinished " << unfinished << ", invalid " << bad << ")\n";
+    std::cout << "Moves: " << moves << " in " << seconds << "s";
+    if (seconds > 0)
+        std::cout << " (" << (long long)(moves / seconds) << " moves/s)";
+    std::cout << "\n";
+    return bad == 0 ? 0 : 1;
+}
+
+// Plays one game with its files in dir and returns the winner, EMPTY for a
+// draw, or -1 if a player could not be started. binary selects the binary
+// state file over the text one. With echo the boards are also printed to
+// stdout. The players' resource use goes to the game's metrics file and,
+// if usage is given, into usage[colour].
+int play_game(const std::string player_filename[3], const std::string& dir, bool protocol, bool binary,
+              const TimeControl& time, bool echo, PlayerMetrics* usage = nullptr) {
+    RecordWriter log(in_dir(dir, file_log));
+    GameMetrics metrics(in_dir(dir, file_metrics));
+#ifndef GOMOKU_POSIX
+    if (protocol) {
+        std::cerr << "Protocol mode is not supported on Windows\n";
+        return -1;
+    }
+#else
+    PlayerProcess players[3];
+    if (protocol) {
+        for (int i = 1; i <= 2; i++) {
+            std::string args;
+            if (!players[i].start(player_filename[i], dir) || !players[i].send("new")
+                || players[i].read_reply("ready", timeout * 1000, args) != PlayerProcess::REPLY_OK) {
+                std::cerr << "Error starting player: " << player_filename[i] << "\n";
+                return -1;
+            }
+        }
+    }
+#endif
+    log.header("black", player_filename[BLACK].c_str());
+    log.header("white", player_filename[WHITE].c_str());
+    GomokuBoard game;
+    std::string data;
+    if (echo) {
+        std::cout << "Player Black File: " << player_filename[BLACK] << std::endl;
+        std::cout << "Player White File: " << player_filename[WHITE] << std::endl;
+        std::cout << game.encode_output();
+    }
+    bool forfeit = false;
+    int clock[3] = {0, time.base_ms, time.base_ms};
+    while (!game.done) {
+        Point p(-1, -1);
+        MoveMetrics move;
+        // The move is due when the per-move limit or the clock runs out.
+        bool clocked = time.base_ms > 0;
+        int move_ms = time.move_limit();
+        bool clock_bound = clocked && (move_ms <= 0 || clock[game.cur_player] <= move_ms);
+        if (clock_bound)
+            move_ms = clock[game.cur_player];
+        // An increment tells the player ms is its whole clock, to be spread
+        // over the game; a per-move limit is the player's to use up.
+        int inc_ms = clock_bound ? time.inc_ms : -1;
+        if (protocol) {
+#ifdef GOMOKU_POSIX
+            PlayerProcess& player = players[game.cur_player];
+            auto start = std::chrono::steady_clock::now();
+            std::string go = "go " + std::to_string(move_ms) + (inc_ms >= 0 ? " " + std::to_string(inc_ms) : "");
+            PlayerProcess::REPLY reply = player.send(go) ? player.read_move(move_ms + PROTOCOL_GRACE_MS, p)
+                                                         : PlayerProcess::REPLY_ERROR;
+            move.timed_out = reply == PlayerProcess::REPLY_TIMEOUT;
+            move.failed = reply == PlayerProcess::REPLY_ERROR;
+            move.wall_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+#endif
+        }
+        else {
+            // Output current state
+            if (binary) {
+                game.record.write(in_dir(dir, file_state).c_str());
+            }
+            else {
+                data = game.encode_state();
+                std::ofstream fout(in_dir(dir, file_state));
+                fout << data;
+                fout.close();
+            }
+            // Run external program
+            move = launch_executable(player_filename[game.cur_player], dir, move_ms, inc_ms);
+            // Read action
+            std::ifstream fin(in_dir(dir, file_action));
+            while (true) {
+                int x, y;
+                if (!(fin >> x)) {
+                    break;
+                }
+                if (!(fin >> y)) break;
+                p.x = x; p.y = y;
+            }
+            fin.close();
+            // Reset action file
+            if (remove(in_dir(dir, file_action).c_str()) != 0)
+                std::cerr << "Error removing file: " << in_dir(dir, file_action) << "\n";
+        }
+        // A player stopped at the per-move limit keeps the last move it
+        // wrote. Under a clock, a move that took longer than the time left
+        // has lost on time, in either mode. A player that failed to reply
+        // has lost on that instead.
+        if (clocked && !move.failed && (move.wall_ms > clock[game.cur_player] || (move.timed_out && clock_bound))) {
+            move.timed_out = true;
+            p = Point(-1, -1);
+        }
+        if (clocked)
+            clock[game.cur_player] = std::max(clock[game.cur_player] - move.wall_ms, 0) + time.inc_ms;
+        metrics.move(game.cur_player, move);
+        // Take action; an invalid action loses.
+        bool valid = game.put_disc(p);
+        const char* reason = valid ? nullptr : move.failed ? "error" : move.timed_out && p.x < 0 ? "timeout" : nullptr;
+        if (echo)
+            std::cout << "Put: (" << p.x << ',' << p.y << ")\n" << game.encode_output(!valid, reason ? reason : "");
+        if (!valid) {
+            log.result(game.encode_player(game.winner).c_str(), true, p, reason);
+            forfeit = true;
+            break;
+        }
+        log.move(p.x, p.y);
+#ifdef GOMOKU_POSIX
+        if (protocol) {
+            std::string move = "play " + std::to_string(p.x) + " " + std::to_string(p.y);
+            players[1].send(move);
+            players[2].send(move);
+        }
+#endif
+    }
+    if (!forfeit)
+        log.result(game.encode_player(game.winner).c_str());
+    log.close();
+#ifdef GOMOKU_POSIX
+    if (protocol) {
+        for (int i = 1; i <= 2; i++)
+            metrics.exit(i, players[i].stop());
+    }
+#endif
+    if (usage) {
+        for (int i = 1; i <= 2; i++)
+            usage[i] = metrics.player(i);
+    }
+    metrics.close();
+    // Reset state file
+    if (!protocol && remove(in_dir(dir, file_state).c_str()) != 0)
+        std::cerr << "Error removing file: " << in_dir(dir, file_state) << "\n";
+    return game.winner;
+}
+
+#ifdef GOMOKU_POSIX
+// Elo difference for a score fraction strictly between 0 and 1.
+double elo_of(double score) {
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// main --tournament [-n games] [-j jobs] [-t ms] [--clock base+inc] [-o dir] [--protocol] [--binary-state] player player...
+//
+// Plays games games between every pair of players, colours alternating,
+// jobs games at a time. Every game runs in its own directory dir/gameNNNN,
+// which is also the players' working directory, so games cannot see each
+// other's state, action or log files. Players get GOMOKU_THREADS=1 unless it
+// is already set, so concurrent games do not fight over cores.
+int run_tournament(int argc, char** argv) {
+    int games = 10;
+    int jobs = (int)std::thread::hardware_concurrency();
+    TimeControl time;
+    bool protocol = false;
+    bool binary = false;
+    std::string base = "tournament";
+    std::vector<std::string> players;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+            games = atoi(argv[++i]);
+        else if (arg == "-j" && i + 1 < argc)
+            jobs = atoi(argv[++i]);
+        else if (arg == "-t" || arg == "--clock") {
+            if (!time.option(argc, argv, i)) {
+                std::cerr << "Bad time control: " << arg << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "-o" && i + 1 < argc)
+            base = argv[++i];
+        else if (arg == "--protocol")
+            protocol = true;
+        else if (arg == "--binary-state")
+            binary = true;
+        else {
+            // Games run in their own directories, so players need full paths.
+            char path[PATH_MAX];
+            if (!realpath(argv[i], path)) {
+                std::cerr << "Player not found: " << argv[i] << "\n";
+                return 1;
+            }
+            if (access(path, X_OK) != 0) {
+                std::cerr << "Player not executable: " << argv[i] << "\n";
+                return 1;
+            }
+            players.push_back(path);
+        }
+    }
+    if (players.size() < 2 || games < 1) {
+        std::cerr << "Usage: main --tournament [-n games] [-j jobs] [-t ms] [--clock base+inc] [-o dir] [--protocol] [--binary-state] player player...\n";
+        return 1;
+    }
+    if (jobs < 1)
+        jobs = 1;
+    setenv("GOMOKU_THREADS", "1", 0);
+    // The engine opens its book, GOMOKU_BOOK or else book.bin, relative to
+    // its working directory, which here is the game's: make the path
+    // absolute while it still means the one in ours.
+    const char* book = getenv("GOMOKU_BOOK");
+    std::string book_path = book ? book : "book.bin";
+    char cwd[PATH_MAX];
+    if (!book_path.empty() && book_path[0] != '/' && getcwd(cwd, sizeof(cwd)))
+        setenv("GOMOKU_BOOK", (std::string(cwd) + "/" + book_path).c_str(), 1);
+    signal(SIGPIPE, SIG_IGN);
+    mkdir(base.c_str(), 0755);
+
+    // Game g of a pairing gives the first player Black when g is even.
+    struct Game {
+        int first, second, black;
+        int winner;
+    };
+    std::vector<Game> schedule;
+    for (size_t a = 0; a < players.size(); a++)
+        for (size_t b = a + 1; b < players.size(); b++)
+            for (int g = 0; g < games; g++)
+                schedule.push_back(Game{(int)a, (int)b, g % 2 == 0 ? (int)a : (int)b, -1});
+
+    std::atomic<size_t> next(0);
+    std::mutex print;
+    std::vector<PlayerMetrics> usage(players.size());
+    std::vector<std::thread> workers;
+    for (int j = 0; j < jobs; j++) {
+        workers.emplace_back([&]() {
+            size_t n;
+            while ((n = next++) < schedule.size()) {
+                Game& game = schedule[n];
+                int white = game.black == game.first ? game.second : game.first;
+                std::string names[3] = {"", players[game.black], players[white]};
+                char name[32];
+                snprintf(name, sizeof(name), "game%04zu", n + 1);
+                std::string dir = in_dir(base, name);
+                mkdir(dir.c_str(), 0755);
+                PlayerMetrics game_usage[3];
+                game.winner = play_game(names, dir, protocol, binary, time, false, game_usage);
+                std::lock_guard<std::mutex> lock(print);
+                usage[game.black].add(game_usage[BLACK]);
+                usage[white].add(game_usage[WHITE]);
+                std::cout << name << ": " << players[game.black] << " (O) vs " << players[white] << " (X): "
+                          << (game.winner == BLACK ? "O wins"
+                              : game.winner == WHITE ? "X wins"
+                              : game.winner == EMPTY ? "draw" : "error") << std::endl;
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    // Results per pairing from the first player's side, with the Elo
+    // difference and its 95% confidence interval from the per-game score
+    // variance.
+    std::cout << "\nResults (" << schedule.size() << " games):\n";
+    for (size_t a = 0; a < players.size(); a++) {
+        for (size_t b = a + 1; b < players.size(); b++) {
+            int wins = 0, draws = 0, losses = 0, errors = 0;
+            for (const Game& game : schedule) {
+                if (game.first != (int)a || game.second != (int)b)
+                    continue;
+                int colour = game.black == (int)a ? BLACK : WHITE;
+                if (game.winner < 0)
+                    errors++;
+                else if (game.winner == EMPTY)
+                    draws++;
+                else if (game.winner == colour)
+                    wins++;
+                else
+                    losses++;
+            }
+            int played = wins + draws + losses;
+            std::cout << players[a] << " vs " << players[b] << ": +" << wins << " =" << draws << " -" << losses;
+            if (errors)
+                std::cout << " (" << errors << " not played)";
+            if (played == 0) {
+                std::cout << "\n";
+                continue;
+            }
+            double score = (wins + 0.5 * draws) / played;
+            std::cout << "  score " << 100.0 * score << "%";
+            if (score <= 0.0 || score >= 1.0) {
+                std::cout << "  Elo " << (score <= 0.0 ? "-inf" : "+inf") << "\n";
+                continue;
+            }
+            double variance = (wins * (1.0 - score) * (1.0 - score) + draws * (0.5 - score) * (0.5 - score)
+                               + losses * score * score) / played;
+            double margin = 1.96 * std::sqrt(variance / played);
+            double low = std::max(score - margin, 1e-6), high = std::min(score + margin, 1.0 - 1e-6);
+            std::cout << "  Elo " << std::showpos << (int)std::lround(elo_of(score)) << std::noshowpos
+                      << " +/- " << (int)std::lround((elo_of(high) - elo_of(low)) / 2) << "\n";
+        }
+    }
+
+    // Resource use per player over all its games; each game's own figures
+    // are in its metrics file.
+    std::cout << "\nResources:\n";
+    for (size_t a = 0; a < players.size(); a++) {
+        std::cout << players[a] << ": " << usage[a].summary() << "\n"
+                  << "  latency " << usage[a].histogram() << "\n";
+    }
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::string(argv[1]) == "--verify")
+        return verify_records(argv[2]);
+    if (argc >= 2 && std::string(argv[1]) == "--tournament") {
+#ifndef GOMOKU_POSIX
+        std::cerr << "Tournament mode is not supported on Windows\n";
+        return 1;
+#else
+        return run_tournament(argc, argv);
+#endif
+    }
+    // main [--protocol | --binary-state] [-t ms] [--clock base+inc] black white [ms per move]
+    bool protocol = false;
+    bool binary = false;
+    TimeControl time;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--protocol")
+            protocol = true;
+        else if (arg == "--binary-state")
+            binary = true;
+        else if (arg == "-t" || arg == "--clock") {
+            if (!time.option(argc, argv, i)) {
+                std::cerr << "Bad time control: " << arg << "\n";
+                return 1;
+            }
+        }
+        else
+            positional.push_back(arg);
+    }
+    if (positional.size() == 3)
+        time.move_ms = atoi(positional[2].c_str());
+    assert(positional.size() == 2 || positional.size() == 3);
+    std::string player_filename[3];
+    player_filename[1] = positional[0];
+    player_filename[2] = positional[1];
+#ifdef GOMOKU_POSIX
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    return play_game(player_filename, "", protocol, binary, time, true) < 0 ? 1 : 0;
+}
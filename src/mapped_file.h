@@ -0,0 +1,82 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "platform.h"
+#ifdef GOMOKU_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A whole file mapped read-only, for data that is used in place rather than
+// parsed. Windows builds read the file into memory instead.
+class MappedFile {
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+    ~MappedFile() {
+        close();
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False if the file is missing or empty.
+    bool open(const char* path) {
+        close();
+#ifndef GOMOKU_POSIX
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+        std::vector<char> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (contents.empty())
+            return false;
+        length = contents.size();
+        bytes = new char[length];
+        std::copy(contents.begin(), contents.end(), bytes);
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED)
+            return false;
+        bytes = static_cast<char*>(map);
+        length = st.st_size;
+#endif
+        return true;
+    }
+    void close() {
+        if (bytes) {
+#ifndef GOMOKU_POSIX
+            delete[] bytes;
+#else
+            munmap(bytes, length);
+#endif
+        }
+        bytes = nullptr;
+        length = 0;
+    }
+    const char* data() const {
+        return bytes;
+    }
+    size_t size() const {
+        return length;
+    }
+
+private:
+    char* bytes;
+    size_t length;
+};
+
+#endif
@@ -0,0 +1,417 @@
+#ifndef MCTS_H
+#define MCTS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <atomic>
+#include <type_traits>
+
+#include "bitboard.h"
+#include "movegen.h"
+#include "threats.h"
+
+// Monte Carlo tree search, the alternative to the alpha-beta engine.
+//
+// Every playout walks the tree by UCT from the root, expands the leaf it
+// reaches and finishes the game with a random rollout on a bitboard copy.
+// Rollouts are random among the empty cells next to a stone, except that a
+// side with a five point plays it and a side facing one blocks it, which
+// keeps them from throwing away won or lost games.
+//
+// Any number of threads may run playouts on one tree. Descending into a node
+// adds VIRTUAL_LOSS visits without wins, so threads passing the same node
+// spread out; the extra visits are taken back when the result is added.
+// Nodes come from one preallocated pool, a node's children are a contiguous
+// block claimed with a single atomic add, and the tree is never freed node by
+// node. When the pool runs out the tree stops growing and playouts roll out
+// from its leaves.
+//
+// A tree kept from one move to the next (protocol mode) is re-rooted at the
+// position reached, so the new search starts with the statistics the last
+// one gathered for it. Nodes outside the new root's subtree are only
+// reclaimed when the tree starts again.
+
+#ifndef MCTS_EXPLORATION
+#define MCTS_EXPLORATION 0.7f
+#endif
+#ifndef VIRTUAL_LOSS
+#define VIRTUAL_LOSS 3
+#endif
+
+// A cell index or a count of cells: a byte while the board has fewer than
+// 256 cells, which keeps nodes at 16 bytes on 15x15.
+typedef std::conditional<BitBoard::SIZE * BitBoard::SIZE < 256, uint8_t, uint16_t>::type MctsCell;
+
+struct MctsNode {
+    std::atomic<int> visits;
+    std::atomic<int> wins;      // half points for the player who moved here
+    int first_child;
+    MctsCell child_count;
+    MctsCell move;              // x * SIZE + y
+    uint8_t terminal;           // the move here made five
+    std::atomic<uint8_t> state;
+};
+
+// xorshift64*, one per thread.
+struct MctsRandom {
+    uint64_t s;
+
+    explicit MctsRandom(uint64_t seed) : s(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+    uint64_t next() {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 0x2545F4914F6CDD1DULL;
+    }
+    int below(int n) {
+        return (int)(((next() >> 32) * (uint64_t)n) >> 32);
+    }
+};
+
+class MctsTree {
+public:
+    typedef BitBoard::Line Line;
+    static const int SIZE = BitBoard::SIZE;
+    static const int CELLS = SIZE * SIZE;
+
+    explicit MctsTree(size_t megabytes)
+        : capacity(megabytes * 1024 * 1024 / sizeof(MctsNode)), next_free(1), pool_full(false), root(0),
+          has_root(false) {
+        if (capacity < 1 + CELLS)
+            capacity = 1 + CELLS;
+        pool = new MctsNode[capacity];
+        reset();
+    }
+    ~MctsTree() {
+        delete[] pool;
+    }
+    MctsTree(const MctsTree&) = delete;
+    MctsTree& operator=(const MctsTree&) = delete;
+
+    // Call before any playout, with no playout running. If the position
+    // follows from the last root by at most one move of each side, the
+    // root's player's first, the search goes on from that subtree; otherwise,
+    // or once half the pool is used, the tree starts again.
+    void set_root(const BitBoard& board, const CandidateMask& candidates, int to_move) {
+        if (!descend(board, to_move))
+            reset();
+        root_board = board;
+        root_candidates = candidates;
+        root_player = to_move;
+        has_root = true;
+    }
+
+    // One playout; safe to call from several threads at once.
+    void playout(MctsRandom& rng) {
+        BitBoard board = root_board;
+        CandidateMask candidates = root_candidates;
+        Point recent[2] = {Point(-1, -1), Point(-1, -1)};
+        int mover = root_player;
+        int path[CELLS + 1];
+        int length = 0;
+        int node = root;
+        int winner;
+        path[length++] = node;
+        pool[node].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+        while (true) {
+            MctsNode& n = pool[node];
+            if (n.terminal) {
+                winner = 3 - mover;
+                break;
+            }
+            if (n.state.load(std::memory_order_acquire) != EXPANDED
+                && !(n.visits.load(std::memory_order_relaxed) > VIRTUAL_LOSS && expand(n, board, candidates, mover))) {
+                winner = rollout(board, candidates, mover, recent, rng);
+                break;
+            }
+            if (n.child_count == 0) {
+                winner = EMPTY;
+                break;
+            }
+            node = select(n);
+            Point p(pool[node].move / SIZE, pool[node].move % SIZE);
+            board.place(p.x, p.y, mover);
+            candidates.add_stone(p.x, p.y);
+            recent[mover - 1] = p;
+            mover = 3 - mover;
+            path[length++] = node;
+            pool[node].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+        }
+        // path[i] was moved into by the root player when i is odd.
+        for (int i = 0; i < length; i++) {
+            int moved = i % 2 ? root_player : 3 - root_player;
+            int points = winner == EMPTY ? 1 : winner == moved ? 2 : 0;
+            pool[path[i]].visits.fetch_add(1 - VIRTUAL_LOSS, std::memory_order_relaxed);
+            pool[path[i]].wins.fetch_add(points, std::memory_order_relaxed);
+        }
+    }
+
+    // Most visited root move, or (-1, -1) before the root is expanded.
+    Point best_move() const {
+        const MctsNode* child = best_child();
+        return child ? Point(child->move / SIZE, child->move % SIZE) : Point(-1, -1);
+    }
+    // Share of points the best move has won, for the side to move.
+    float best_winrate() const {
+        const MctsNode* child = best_child();
+        int visits = child ? child->visits.load(std::memory_order_relaxed) : 0;
+        return visits > 0 ? child->wins.load(std::memory_order_relaxed) / (2.0f * visits) : 0.5f;
+    }
+    // Number of legal root moves the tree considers; 1 when forced.
+    int root_moves() const {
+        const MctsNode& n = pool[root];
+        return n.state.load(std::memory_order_acquire) == EXPANDED ? n.child_count : 0;
+    }
+    int root_visits() const {
+        return pool[root].visits.load(std::memory_order_relaxed);
+    }
+    size_t node_count() const {
+        size_t n = next_free.load(std::memory_order_relaxed);
+        return n < capacity ? n : capacity;
+    }
+
+private:
+    enum NODE_STATE {
+        LEAF = 0,
+        EXPANDING = 1,
+        EXPANDED = 2
+    };
+
+    MctsNode* pool;
+    size_t capacity;
+    std::atomic<size_t> next_free;
+    std::atomic<bool> pool_full;
+    int root;
+    bool has_root;
+    BitBoard root_board;
+    CandidateMask root_candidates;
+    int root_player;
+
+    void reset() {
+        next_free.store(1, std::memory_order_relaxed);
+        pool_full.store(false, std::memory_order_relaxed);
+        root = 0;
+        init_node(pool[0], 0, false);
+    }
+    // Moves the root down to board, to_move to play, if it is at most one
+    // move of each side below the current root and the tree has those
+    // moves. False if the tree has to start again.
+    bool descend(const BitBoard& board, int to_move) {
+        if (!has_root || pool_full.load(std::memory_order_relaxed)
+            || next_free.load(std::memory_order_relaxed) > capacity / 2)
+            return false;
+        // played[0] is the root player's move, played[1] the reply.
+        Point played[2];
+        int count[3] = {};
+        for (int x = 0; x < SIZE; x++) {
+            for (int y = 0; y < SIZE; y++) {
+                int now = board.get(x, y), before = root_board.get(x, y);
+                if (now == before)
+                    continue;
+                if (before != EMPTY || count[now] > 0)
+                    return false;
+                count[now]++;
+                played[now == root_player ? 0 : 1] = Point(x, y);
+            }
+        }
+        int moves = count[root_player] + count[3 - root_player];
+        if (count[3 - root_player] > count[root_player] || to_move != (moves % 2 ? 3 - root_player : root_player))
+            return false;
+        int node = root;
+        for (int i = 0; i < moves; i++) {
+            node = child(node, played[i]);
+            if (node < 0)
+                return false;
+        }
+        root = node;
+        return true;
+    }
+    // The child of node for move p, or -1 if it has none or the game ended
+    // there.
+    int child(int node, Point p) const {
+        const MctsNode& n = pool[node];
+        if (n.state.load(std::memory_order_acquire) != EXPANDED)
+            return -1;
+        for (int i = 0; i < n.child_count; i++) {
+            const MctsNode& c = pool[n.first_child + i];
+            if (c.move == p.x * SIZE + p.y)
+                return c.terminal ? -1 : n.first_child + i;
+        }
+        return -1;
+    }
+
+    static void init_node(MctsNode& n, int move, bool terminal) {
+        n.visits.store(0, std::memory_order_relaxed);
+        n.wins.store(0, std::memory_order_relaxed);
+        n.first_child = 0;
+        n.child_count = 0;
+        n.move = (MctsCell)move;
+        n.terminal = terminal;
+        n.state.store(LEAF, std::memory_order_relaxed);
+    }
+
+    const MctsNode* best_child() const {
+        const MctsNode& n = pool[root];
+        if (n.state.load(std::memory_order_acquire) != EXPANDED || n.child_count == 0)
+            return nullptr;
+        const MctsNode* best = &pool[n.first_child];
+        for (int i = 1; i < n.child_count; i++) {
+            const MctsNode* child = &pool[n.first_child + i];
+            if (child->visits.load(std::memory_order_relaxed) > best->visits.load(std::memory_order_relaxed))
+                best = child;
+        }
+        return best;
+    }
+
+    // UCT; unvisited children first, in generation order.
+    int select(const MctsNode& n) const {
+        float log_parent = std::log((float)n.visits.load(std::memory_order_relaxed) + 1.0f);
+        int best = n.first_child;
+        float best_value = -1.0f;
+        for (int i = 0; i < n.child_count; i++) {
+            const MctsNode& child = pool[n.first_child + i];
+            int visits = child.visits.load(std::memory_order_relaxed);
+            if (visits == 0)
+                return n.first_child + i;
+            float value = child.wins.load(std::memory_order_relaxed) / (2.0f * visits)
+                        + MCTS_EXPLORATION * std::sqrt(log_parent / visits);
+            if (value > best_value) {
+                best_value = value;
+                best = n.first_child + i;
+            }
+        }
+        return best;
+    }
+
+    // Gives n its children: the winning cell if the side to move has a five
+    // point, otherwise the cells blocking the opponent's five points,
+    // otherwise every empty cell next to a stone. Returns false if another
+    // thread is expanding n or the pool is full.
+    bool expand(MctsNode& n, const BitBoard& board, const CandidateMask& candidates, int mover) {
+        if (pool_full.load(std::memory_order_relaxed))
+            return false;
+        uint8_t expected = LEAF;
+        if (!n.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire))
+            return false;
+        Point moves[CELLS];
+        int count;
+        bool wins = false;
+        CellSet own = five_points(board, mover);
+        if (own.count() > 0) {
+            own.list(moves);
+            count = 1;
+            wins = true;
+        }
+        else {
+            CellSet opp = five_points(board, 3 - mover);
+            count = opp.count() > 0 ? opp.list(moves) : neighbours(board, candidates, moves);
+        }
+        size_t first = next_free.fetch_add(count, std::memory_order_relaxed);
+        if (first + count > capacity) {
+            pool_full.store(true, std::memory_order_relaxed);
+            n.state.store(LEAF, std::memory_order_release);
+            return false;
+        }
+        for (int i = 0; i < count; i++)
+            init_node(pool[first + i], moves[i].x * SIZE + moves[i].y, wins);
+        n.first_child = (int)first;
+        n.child_count = (MctsCell)count;
+        n.state.store(EXPANDED, std::memory_order_release);
+        return true;
+    }
+
+    static CellSet five_points(const BitBoard& board, int disc) {
+        CellSet set;
+        const Line* own = board.stones[disc - 1];
+        const Line* opp = board.stones[2 - disc];
+        for (int l = 0; l < BitBoard::LINES; l++)
+            if (own[l])
+                set.add_line(l, ThreatSolver::five_cells(own[l], opp[l], BitBoard::line_mask(l)));
+        return set;
+    }
+
+    // Empty cells at distance 1 from a stone; the centre on an empty board.
+    static int neighbours(const BitBoard& board, const CandidateMask& candidates, Point* out) {
+        int n = 0;
+        bool stones = false;
+        for (int x = 0; x < SIZE; x++) {
+            Line occupied = board.occupied(BitBoard::line_index(BitBoard::HORIZONTAL, x, 0));
+            stones |= occupied != 0;
+            Line cells = candidates.near[x] & ~occupied;
+            while (cells) {
+                out[n++] = Point(x, __builtin_ctz(cells));
+                cells &= cells - 1;
+            }
+        }
+        if (!stones)
+            out[n++] = Point(SIZE / 2, SIZE / 2);
+        return n;
+    }
+
+    // A five point of disc on a line through p, if any.
+    static bool five_point_near(const BitBoard& board, int disc, Point p, Point& out) {
+        if (p.x < 0)
+            return false;
+        for (int dir = 0; dir < 4; dir++) {
+            int l = BitBoard::line_index(dir, p.x, p.y);
+            Line cells = ThreatSolver::five_cells(board.stones[disc - 1][l], board.stones[2 - disc][l], BitBoard::line_mask(l));
+            if (cells) {
+                out = BitBoard::cell_of(l, __builtin_ctz(cells));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Plays the game out and returns the winner, or EMPTY for a draw. Five
+    // points are only looked for on the lines through each side's last move,
+    // which is where new ones appear.
+    static int rollout(BitBoard& board, const CandidateMask& candidates, int mover, Point* recent, MctsRandom& rng) {
+        Point cells[CELLS];
+        int index[CELLS];
+        Line listed[SIZE];
+        int count = 0;
+        for (int x = 0; x < SIZE; x++) {
+            listed[x] = candidates.near[x] | board.occupied(BitBoard::line_index(BitBoard::HORIZONTAL, x, 0));
+            Line empty = candidates.near[x] & ~board.occupied(BitBoard::line_index(BitBoard::HORIZONTAL, x, 0));
+            while (empty) {
+                int y = __builtin_ctz(empty);
+                empty &= empty - 1;
+                index[x * SIZE + y] = count;
+                cells[count++] = Point(x, y);
+            }
+        }
+        while (true) {
+            Point p;
+            if (!five_point_near(board, mover, recent[mover - 1], p)
+                && !five_point_near(board, 3 - mover, recent[2 - mover], p)) {
+                if (count == 0)
+                    return EMPTY;
+                p = cells[rng.below(count)];
+            }
+            board.place(p.x, p.y, mover);
+            if (board.is_five(p.x, p.y, mover))
+                return mover;
+            if (listed[p.x] & (Line(1) << p.y)) {
+                int i = index[p.x * SIZE + p.y];
+                cells[i] = cells[--count];
+                index[cells[i].x * SIZE + cells[i].y] = i;
+            }
+            listed[p.x] |= Line(1) << p.y;
+            for (int x = p.x - 1; x <= p.x + 1; x++) {
+                for (int y = p.y - 1; y <= p.y + 1; y++) {
+                    if (BitBoard::is_on_board(x, y) && !(listed[x] & (Line(1) << y))) {
+                        listed[x] |= Line(1) << y;
+                        index[x * SIZE + y] = count;
+                        cells[count++] = Point(x, y);
+                    }
+                }
+            }
+            recent[mover - 1] = p;
+            mover = 3 - mover;
+        }
+    }
+};
+
+#endif
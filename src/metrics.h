@@ -0,0 +1,169 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdio>
+#include <string>
+
+#include "platform.h"
+#ifdef GOMOKU_POSIX
+#include <sys/resource.h>
+#endif
+
+// Resource use of the players as the arbiter measures it, and the per-game
+// metrics file:
+//   # move player wall_ms user_ms sys_ms max_rss_kb
+//   1 O 812 790 12 70312
+//   ...
+//   # player O moves 30 wall_ms avg 640 max 9120 user_ms 18210 sys_ms 240 max_rss_kb 70312 timeouts 0 errors 0
+//   # latency O <=10ms 0 <=50ms 2 ... >10000ms 0
+// A file-mode player runs once per move, so every move has its own CPU time
+// and peak RSS. A --protocol player lives for the whole game: its moves
+// have wall time only (-1 for the rest) and the player's totals come from
+// its exit. A move line ends in "timeout" if the player ran out of time and
+// in "error" if it exited or its reply was not a move. Windows builds
+// measure wall time only.
+
+const int LATENCY_BUCKETS = 10;
+const int LATENCY_LIMITS_MS[LATENCY_BUCKETS - 1] = {10, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+
+struct MoveMetrics {
+    int wall_ms = 0;
+    int user_ms = -1;
+    int sys_ms = -1;
+    long max_rss_kb = -1;
+    bool timed_out = false;
+    bool failed = false;        // no move: the player exited or replied garbage
+
+#ifdef GOMOKU_POSIX
+    // Takes the CPU time and peak RSS of a process reaped by wait4.
+    void set_usage(const struct rusage& usage) {
+        user_ms = (int)(usage.ru_utime.tv_sec * 1000 + usage.ru_utime.tv_usec / 1000);
+        sys_ms = (int)(usage.ru_stime.tv_sec * 1000 + usage.ru_stime.tv_usec / 1000);
+#ifdef __APPLE__
+        max_rss_kb = usage.ru_maxrss / 1024;
+#else
+        max_rss_kb = usage.ru_maxrss;
+#endif
+    }
+#endif
+};
+
+// Totals and latency histogram of one player (or colour).
+struct PlayerMetrics {
+    int moves = 0;
+    long long wall_ms = 0;
+    int max_wall_ms = 0;
+    long long user_ms = 0;
+    long long sys_ms = 0;
+    long max_rss_kb = -1;
+    int timeouts = 0;
+    int errors = 0;
+    int latency[LATENCY_BUCKETS] = {};
+
+    void add_move(const MoveMetrics& move) {
+        moves++;
+        wall_ms += move.wall_ms;
+        if (move.wall_ms > max_wall_ms)
+            max_wall_ms = move.wall_ms;
+        int bucket = 0;
+        while (bucket < LATENCY_BUCKETS - 1 && move.wall_ms > LATENCY_LIMITS_MS[bucket])
+            bucket++;
+        latency[bucket]++;
+        if (move.timed_out)
+            timeouts++;
+        if (move.failed)
+            errors++;
+        add_usage(move);
+    }
+    // CPU time and peak RSS without a move, for a player's exit.
+    void add_usage(const MoveMetrics& usage) {
+        if (usage.user_ms >= 0) {
+            user_ms += usage.user_ms;
+            sys_ms += usage.sys_ms;
+        }
+        if (usage.max_rss_kb > max_rss_kb)
+            max_rss_kb = usage.max_rss_kb;
+    }
+    void add(const PlayerMetrics& other) {
+        moves += other.moves;
+        wall_ms += other.wall_ms;
+        if (other.max_wall_ms > max_wall_ms)
+            max_wall_ms = other.max_wall_ms;
+        user_ms += other.user_ms;
+        sys_ms += other.sys_ms;
+        if (other.max_rss_kb > max_rss_kb)
+            max_rss_kb = other.max_rss_kb;
+        timeouts += other.timeouts;
+        errors += other.errors;
+        for (int i = 0; i < LATENCY_BUCKETS; i++)
+            latency[i] += other.latency[i];
+    }
+
+    // "moves 30 wall_ms avg 640 max 9120 ... timeouts 0 errors 0"
+    std::string summary() const {
+        char line[256];
+        snprintf(line, sizeof(line), "moves %d wall_ms avg %lld max %d user_ms %lld sys_ms %lld max_rss_kb %ld timeouts %d errors %d",
+                 moves, moves ? wall_ms / moves : 0, max_wall_ms, user_ms, sys_ms, max_rss_kb, timeouts, errors);
+        return line;
+    }
+    // "<=10ms 0 <=50ms 2 ... >10000ms 0"
+    std::string histogram() const {
+        std::string out;
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            int limit = LATENCY_LIMITS_MS[i < LATENCY_BUCKETS - 1 ? i : LATENCY_BUCKETS - 2];
+            out += (i ? " " : "") + std::string(i < LATENCY_BUCKETS - 1 ? "<=" : ">") + std::to_string(limit)
+                 + "ms " + std::to_string(latency[i]);
+        }
+        return out;
+    }
+};
+
+// The metrics file of one game. Moves are written as they are played; the
+// per-colour summary is written by close().
+class GameMetrics {
+public:
+    explicit GameMetrics(const std::string& path) : file(fopen(path.c_str(), "w")), count(0) {
+        if (file)
+            fputs("# move player wall_ms user_ms sys_ms max_rss_kb\n", file);
+    }
+    ~GameMetrics() {
+        close();
+    }
+    GameMetrics(const GameMetrics&) = delete;
+    GameMetrics& operator=(const GameMetrics&) = delete;
+
+    // colour is 1 (O) or 2 (X).
+    void move(int colour, const MoveMetrics& move) {
+        players[colour].add_move(move);
+        if (file)
+            fprintf(file, "%d %c %d %d %d %ld%s\n", ++count, name(colour), move.wall_ms, move.user_ms, move.sys_ms,
+                    move.max_rss_kb, move.timed_out ? " timeout" : move.failed ? " error" : "");
+    }
+    void exit(int colour, const MoveMetrics& usage) {
+        players[colour].add_usage(usage);
+    }
+    const PlayerMetrics& player(int colour) const {
+        return players[colour];
+    }
+    void close() {
+        if (!file)
+            return;
+        for (int colour = 1; colour <= 2; colour++)
+            fprintf(file, "# player %c %s\n", name(colour), players[colour].summary().c_str());
+        for (int colour = 1; colour <= 2; colour++)
+            fprintf(file, "# latency %c %s\n", name(colour), players[colour].histogram().c_str());
+        fclose(file);
+        file = nullptr;
+    }
+
+private:
+    FILE* file;
+    int count;
+    PlayerMetrics players[3];
+
+    static char name(int colour) {
+        return colour == 1 ? 'O' : 'X';
+    }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "bitboard.h"
+
+// Candidate moves: the empty cells next to a stone of either colour, or two
+// steps away from one along a line. Kept as one row mask per ring and updated
+// by OR-ing a fixed stamp around every stone placed, so generating moves is a
+// walk over set bits with no duplicates and no allocation. Cells that have
+// been taken are filtered out against the board when generating. Templated
+// on the board type; the programs use the CandidateMask typedef.
+template <class Board>
+class BasicCandidateMask {
+public:
+    typedef typename Board::Line Line;
+    static const int SIZE = Board::SIZE;
+    static const int MAX_MOVES = SIZE * SIZE;
+
+    Line near[SIZE];    // distance 1
+    Line far[SIZE];     // distance 1 or 2
+
+    BasicCandidateMask() {
+        reset();
+    }
+    void reset() {
+        for (int x = 0; x < SIZE; x++) {
+            near[x] = 0;
+            far[x] = 0;
+        }
+    }
+    void add_stone(int x, int y) {
+        stamp(near, x - 1, (Line(7) << y) >> 1);
+        stamp(near, x, (Line(5) << y) >> 1);
+        stamp(near, x + 1, (Line(7) << y) >> 1);
+        stamp(far, x - 2, (Line(21) << y) >> 2);
+        stamp(far, x - 1, (Line(7) << y) >> 1);
+        stamp(far, x, (Line(27) << y) >> 2);
+        stamp(far, x + 1, (Line(7) << y) >> 1);
+        stamp(far, x + 2, (Line(21) << y) >> 2);
+    }
+    // Writes the empty candidates to out, distance-1 cells first, and
+    // returns how many there are.
+    int generate(const Board& board, Point* out) const {
+        int n = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int x = 0; x < SIZE; x++) {
+                Line empty = ~board.occupied(Board::line_index(Board::HORIZONTAL, x, 0));
+                Line cells = pass == 0 ? near[x] & empty : far[x] & ~near[x] & empty;
+                while (cells) {
+                    int y = __builtin_ctz(cells);
+                    cells &= cells - 1;
+                    out[n++] = Point(x, y);
+                }
+            }
+        }
+        return n;
+    }
+
+private:
+    static void stamp(Line* rows, int x, Line bits) {
+        if (0 <= x && x < SIZE)
+            rows[x] |= bits & Board::FULL;
+    }
+};
+
+typedef BasicCandidateMask<BitBoard> CandidateMask;
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef ORDERING_H
+#define ORDERING_H
+
+#include "bitboard.h"
+
+// Move ordering tables of one search thread. Moves are tried as
+//   the hash move, the two killers of the ply, the counter-move to the
+//   opponent's last move, then by history score
+// with generation order (distance-1 cells first) breaking ties. Moves are
+// cells, x * SIZE + y, and colours index the tables directly.
+//   killers    the last two moves that failed high at each ply
+//   history    butterfly table [colour][cell], raised by depth^2 for every
+//              cutoff and halved by age() so older iterations fade out
+//   counter    [colour][opponent's last move], the reply that last refuted it
+
+const int ORDERING_MAX_PLY = 64;
+
+class MoveOrdering {
+public:
+    static const int CELLS = BitBoard::SIZE * BitBoard::SIZE;
+    static const int NO_MOVE = -1;
+
+    MoveOrdering() {
+        clear();
+    }
+    void clear() {
+        for (int ply = 0; ply < ORDERING_MAX_PLY; ply++)
+            killers[ply][0] = killers[ply][1] = NO_MOVE;
+        for (int colour = 0; colour < 3; colour++) {
+            for (int cell = 0; cell < CELLS; cell++) {
+                history[colour][cell] = 0;
+                counter[colour][cell] = NO_MOVE;
+            }
+        }
+    }
+    // Before each iteration: history from shallower searches counts for
+    // less. Killers and counter-moves are replaced as they go.
+    void age() {
+        for (int colour = 0; colour < 3; colour++)
+            for (int cell = 0; cell < CELLS; cell++)
+                history[colour][cell] >>= 1;
+    }
+    // For a new move: the killers were for other plies.
+    void new_search() {
+        for (int ply = 0; ply < ORDERING_MAX_PLY; ply++)
+            killers[ply][0] = killers[ply][1] = NO_MOVE;
+        age();
+    }
+
+    // Scores moves[0..count) for colour to move at ply, after the
+    // opponent's last_move (NO_MOVE if unknown).
+    void score(const Point* moves, int count, int* scores, int hash_move, int colour, int ply, int last_move) const {
+        int reply = last_move == NO_MOVE ? NO_MOVE : counter[colour][last_move];
+        for (int n = 0; n < count; n++) {
+            int move = moves[n].x * BitBoard::SIZE + moves[n].y;
+            if (move == hash_move)
+                scores[n] = HASH_SCORE;
+            else if (move == killers[ply][0])
+                scores[n] = KILLER_SCORE + 1;
+            else if (move == killers[ply][1])
+                scores[n] = KILLER_SCORE;
+            else if (move == reply)
+                scores[n] = COUNTER_SCORE;
+            else
+                scores[n] = history[colour][move];
+        }
+    }
+    // Moves the best scored of moves[n..count) to n. Picking one at a time
+    // leaves the rest unsorted when a cutoff comes early.
+    static void pick(Point* moves, int* scores, int n, int count) {
+        int best = n;
+        for (int i = n + 1; i < count; i++)
+            if (scores[i] > scores[best])
+                best = i;
+        if (best != n) {
+            Point move = moves[best];
+            moves[best] = moves[n];
+            moves[n] = move;
+            int score = scores[best];
+            scores[best] = scores[n];
+            scores[n] = score;
+        }
+    }
+
+    // Records that move failed high for colour at ply and depth.
+    void cutoff(int move, int colour, int ply, int depth, int last_move) {
+        if (killers[ply][0] != move) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = move;
+        }
+        if (last_move != NO_MOVE)
+            counter[colour][last_move] = move;
+        history[colour][move] += depth * depth;
+        if (history[colour][move] >= HISTORY_MAX) {
+            for (int cell = 0; cell < CELLS; cell++)
+                history[colour][cell] >>= 1;
+        }
+    }
+
+private:
+    // History stays below the fixed scores, which keep their order.
+    static const int HISTORY_MAX = 1 << 20;
+    static const int COUNTER_SCORE = HISTORY_MAX;
+    static const int KILLER_SCORE = HISTORY_MAX + 1;
+    static const int HASH_SCORE = HISTORY_MAX + 3;
+
+    int killers[ORDERING_MAX_PLY][2];
+    int history[3][CELLS];
+    int counter[3][CELLS];
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef PATTERNS_H
+#define PATTERNS_H
+
+#include "bitboard.h"
+
+// Shape scores for one window of WIN_LENGTH + 1 cells, generated at compile
+// time. A window is indexed by two bitmasks over its cells, the stones of the
+// side being scored and the cells it cannot use (opponent stones and the
+// board edge): index = own | blocked << CELLS.
+//
+// Shapes are ranked by how many stones a WIN_LENGTH span still misses:
+//   five     XXXXX                            PATTERN_FIVE
+//   four     .XXXX.  open                     100
+//            XXXX. XX.XX X.XXX  closed        70
+//   three    .XXX.. .XX.X.  open              40
+//            XXX.. XX.X. X..XX  closed        30
+//   two      .XX... .X.X..  open              10
+//            XX... X.X..  closed              5
+//   one      open 2, closed 1
+// "Open" means both ends of the window are empty and nothing inside is
+// blocked. New shapes only need a case in pattern_score().
+
+// Each win length has its own table, Patterns<WinLength>::table, in which
+// a complete row of any length scores PATTERN_FIVE.
+
+constexpr int shape_value(int missing, bool open) {
+    return missing == 1 ? (open ? 100 : 70)
+         : missing == 2 ? (open ? 40 : 30)
+         : missing == 3 ? (open ? 10 : 5)
+         : (open ? 2 : 1);
+}
+
+constexpr int count_bits(int v) {
+    int n = 0;
+    for (; v; v &= v - 1)
+        n++;
+    return n;
+}
+
+const int PATTERN_FIVE = 1000000;
+
+template <int WinLength>
+struct PatternTable {
+    static const int CELLS = WinLength + 1;
+    static const int MASK = (1 << CELLS) - 1;
+    static const int ENTRIES = 1 << (2 * CELLS);
+    int score[ENTRIES];
+};
+
+template <int WinLength>
+constexpr int pattern_score(int own, int blocked) {
+    const int cells_count = WinLength + 1;
+    if (own & blocked)
+        return 0;
+    const int span = (1 << WinLength) - 1;
+    int best = 0;
+    for (int start = 0; start + WinLength <= cells_count; start++) {
+        int cells = span << start;
+        if (blocked & cells)
+            continue;
+        int stones = count_bits(own & cells);
+        if (stones == WinLength)
+            return PATTERN_FIVE;
+        if (stones > 0 && shape_value(WinLength - stones, false) > best)
+            best = shape_value(WinLength - stones, false);
+    }
+    const int ends = 1 | (1 << (cells_count - 1));
+    if (!blocked && !(own & ends)) {
+        int stones = count_bits(own);
+        if (stones > 0 && shape_value(WinLength - stones, true) > best)
+            best = shape_value(WinLength - stones, true);
+    }
+    return best;
+}
+
+template <int WinLength>
+constexpr PatternTable<WinLength> make_pattern_table() {
+    typedef PatternTable<WinLength> Table;
+    Table table{};
+    for (int i = 0; i < Table::ENTRIES; i++)
+        table.score[i] = pattern_score<WinLength>(i & Table::MASK, i >> Table::CELLS);
+    return table;
+}
+
+template <int WinLength>
+struct Patterns {
+    static constexpr PatternTable<WinLength> table = make_pattern_table<WinLength>();
+};
+template <int WinLength>
+constexpr PatternTable<WinLength> Patterns<WinLength>::table;
+
+// Index of a window of WIN_LENGTH + 1 cells written as a string, 'X' own,
+// '.' empty, anything else blocked; first character is the lowest bit.
+constexpr int pattern_index(const char* shape) {
+    int own = 0, blocked = 0, cells = 0;
+    for (; shape[cells]; cells++) {
+        if (shape[cells] == 'X')
+            own |= 1 << cells;
+        else if (shape[cells] != '.')
+            blocked |= 1 << cells;
+    }
+    return own | blocked << cells;
+}
+
+static_assert(Patterns<5>::table.score[pattern_index("XXXXX.")] == PATTERN_FIVE, "five");
+static_assert(Patterns<5>::table.score[pattern_index(".XXXX.")] == 100, "open four");
+static_assert(Patterns<5>::table.score[pattern_index("XX.XX|")] == 70, "split four");
+static_assert(Patterns<5>::table.score[pattern_index(".XX.X.")] == 40, "split three");
+static_assert(Patterns<5>::table.score[pattern_index("|XXX..")] == 30, "closed three");
+static_assert(Patterns<5>::table.score[pattern_index("|XXX.|")] == 0, "dead three");
+static_assert(Patterns<6>::table.score[pattern_index("XXXXXX.")] == PATTERN_FIVE, "six");
+static_assert(Patterns<6>::table.score[pattern_index(".XXXXX.")] == 100, "open five of six");
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// GOMOKU_POSIX is defined everywhere but Windows. The arbiter's process
+// control (fork, pipes, wait4) and the memory-mapped files need it.
+#if !(defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__))
+#define GOMOKU_POSIX
+#endif
+
+#endif
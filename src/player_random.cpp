@@ -1,50 +1,108 @@
-#include <iostream>
-#include <fstream>
-#include <cstdlib>
-#include <ctime>
-#include <array>
-
-enum SPOT_STATE {
-    EMPTY = 0,
-    BLACK = 1,
-    WHITE = 2
-};
-
-int player;
-const int SIZE = 15;
-std::array<std::array<int, SIZE>, SIZE> board;
-
-void read_board(std::ifstream& fin) {
-    fin >> player;
-    for (int i = 0; i < SIZE; i++) {
-        for (int j = 0; j < SIZE; j++) {
-            fin >> board[i][j];
-        }
-    }
-}
-
-void write_valid_spot(std::ofstream& fout) {
-    srand(time(NULL));
-    int x, y;
-    // Keep updating the output until getting killed.
-    while(true) {
-        // Choose a random spot.
-        int x = (rand() % SIZE);
-        int y = (rand() % SIZE);
-        if (board[x][y] == EMPTY) {
-            fout << x << " " << y << std::endl;
-            // Remember to flush the output to ensure the last action is written to file.
-            fout.flush();
-        }
-    }
-}
-
-int main(int, char** argv) {
-    std::ifstream fin(argv[1]);
-    std::ofstream fout(argv[2]);
-    read_board(fin);
-    write_valid_spot(fout);
-    fin.close();
-    fout.close();
-    return 0;
-}
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <ctime>
+#include <array>
+#include <string>
+#include <sstream>
+
+#include "state_format.h"
+
+enum SPOT_STATE {
+    EMPTY = 0,
+    BLACK = 1,
+    WHITE = 2
+};
+
+int player;
+const int SIZE = STATE_SIZE;
+std::array<std::array<int, SIZE>, SIZE> board;
+
+void read_board(std::ifstream& fin) {
+    fin >> player;
+    for (int i = 0; i < SIZE; i++) {
+        for (int j = 0; j < SIZE; j++) {
+            fin >> board[i][j];
+        }
+    }
+}
+
+void write_valid_spot(std::ofstream& fout) {
+    srand(time(NULL));
+    int x, y;
+    // Keep choosing until an empty spot comes up.
+    while(true) {
+        // Choose a random spot.
+        int x = (rand() % SIZE);
+        int y = (rand() % SIZE);
+        if (board[x][y] == EMPTY) {
+            fout << x << " " << y << std::endl;
+            // Nothing better will come, so tell the arbiter not to wait for
+            // the rest of the move's time. Remember to flush the output to
+            // ensure the last action is written to file.
+            fout << "final" << std::endl;
+            fout.flush();
+            return;
+        }
+    }
+}
+
+// Protocol mode, see attempt.cpp: answers every "go" with a random empty
+// spot at once.
+void run_protocol() {
+    srand(time(NULL));
+    int turn = BLACK;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+        if (command == "new") {
+            for (auto& row : board)
+                row.fill(EMPTY);
+            turn = BLACK;
+            std::cout << "ready" << std::endl;
+        }
+        else if (command == "play") {
+            int x, y;
+            if (in >> x >> y && 0 <= x && x < SIZE && 0 <= y && y < SIZE) {
+                board[x][y] = turn;
+                turn = 3 - turn;
+            }
+        }
+        else if (command == "go") {
+            int x, y;
+            do {
+                x = rand() % SIZE;
+                y = rand() % SIZE;
+            } while (board[x][y] != EMPTY);
+            std::cout << "move " << x << " " << y << std::endl;
+        }
+        else if (command == "quit") {
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "--protocol") {
+        run_protocol();
+        return 0;
+    }
+    std::ofstream fout(argv[2]);
+    StateFile binary;
+    if (binary.open(argv[1])) {
+        player = binary.state()->to_move;
+        for (int i = 0; i < SIZE; i++)
+            for (int j = 0; j < SIZE; j++)
+                board[i][j] = binary.state()->cell(i, j);
+    }
+    else {
+        std::ifstream fin(argv[1]);
+        read_board(fin);
+        fin.close();
+    }
+    write_valid_spot(fout);
+    fout.close();
+    return 0;
+}
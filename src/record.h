@@ -0,0 +1,144 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <cstdio>
+#include <string>
+
+#include "bitboard.h"
+
+// Game records. A record keeps the moves rather than the boards:
+//   # black <player>
+//   # white <player>
+//   7 7 6 8 8 8 ...
+//   # result O|X|Draw [invalid x y [timeout|error]]
+// Every line but the moves is a '#' comment, so a file of records is also
+// valid input for "main --verify". An invalid final move is kept in the
+// result line only; the move line holds the moves that were played. A
+// player that ran out of time has the reason timeout, and one that exited
+// or sent no readable move the reason error; their move is -1 -1.
+// Boards for any timestep are rebuilt on demand by the replay tool.
+
+#ifndef RECORD_BUFFER
+#define RECORD_BUFFER 4096
+#endif
+
+// The arbiter's words for a game lost on an invalid move, by the result
+// line's reason.
+inline std::string forfeit_text(const std::string& reason) {
+    if (reason == "timeout")
+        return "Opponent ran out of time";
+    if (reason == "error")
+        return "Opponent did not reply with a move";
+    return "Opponent performed invalid move";
+}
+
+// Buffered writer for one record file. Moves are formatted straight into a
+// fixed buffer, so logging a move allocates nothing and rarely writes.
+class RecordWriter {
+public:
+    explicit RecordWriter(const std::string& path) : file(fopen(path.c_str(), "w")), used(0) {}
+    ~RecordWriter() {
+        close();
+    }
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    void header(const char* key, const char* value) {
+        put("# ");
+        put(key);
+        put(' ');
+        put(value);
+        put('\n');
+    }
+    void move(int x, int y) {
+        put_int(x);
+        put(' ');
+        put_int(y);
+        put(' ');
+    }
+    // Ends the move line and records the result.
+    void result(const char* winner, bool invalid = false, Point p = Point(-1, -1), const char* reason = nullptr) {
+        put("\n# result ");
+        put(winner);
+        if (invalid) {
+            put(" invalid ");
+            put_int(p.x);
+            put(' ');
+            put_int(p.y);
+            if (reason) {
+                put(' ');
+                put(reason);
+            }
+        }
+        put('\n');
+    }
+    void flush() {
+        if (file && used)
+            fwrite(buffer, 1, used, file);
+        used = 0;
+    }
+    void close() {
+        flush();
+        if (file)
+            fclose(file);
+        file = nullptr;
+    }
+
+private:
+    FILE* file;
+    char buffer[RECORD_BUFFER];
+    size_t used;
+
+    void put(char c) {
+        if (used == sizeof(buffer))
+            flush();
+        buffer[used++] = c;
+    }
+    void put(const char* s) {
+        while (*s)
+            put(*s++);
+    }
+    void put_int(int v) {
+        if (v < 0) {
+            put('-');
+            v = -v;
+        }
+        char digits[12];
+        int n = 0;
+        do {
+            digits[n++] = '0' + v % 10;
+            v /= 10;
+        } while (v);
+        while (n)
+            put(digits[--n]);
+    }
+};
+
+// Appends a board in the arbiter's display format:
+//   Timestep #n
+//   <status>
+//   +-----------------------------+
+//   |. . O X ...|
+//   ===============================
+inline void render_board(std::string& out, const BitBoard& board, int timestep, const std::string& status) {
+    static const char spot[3] = {'.', 'O', 'X'};
+    out += "Timestep #";
+    out += std::to_string(timestep);
+    out += '\n';
+    out += status;
+    out += "\n+";
+    out.append(2 * BitBoard::SIZE - 1, '-');
+    out += "+\n";
+    for (int x = 0; x < BitBoard::SIZE; x++) {
+        out += '|';
+        for (int y = 0; y < BitBoard::SIZE; y++) {
+            out += spot[board.get(x, y)];
+            out += y + 1 < BitBoard::SIZE ? ' ' : '|';
+        }
+        out += '\n';
+    }
+    out.append(2 * BitBoard::SIZE + 1, '=');
+    out += '\n';
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "bitboard.h"
+#include "record.h"
+
+// Renders timesteps of a game record written by main (see record.h):
+//   replay record [timestep | all] [game]
+// Timestep #1 is the empty board and #n the board after n - 1 moves, as in
+// the arbiter's output; the default is the final position. game counts
+// records from 1 in a file holding several.
+
+struct GameRecord {
+    std::string black, white;
+    std::vector<Point> moves;
+    std::string winner;     // from the result line, empty if there is none
+    bool invalid = false;
+    std::string reason;     // of an invalid last move: timeout, error or empty
+};
+
+std::vector<GameRecord> read_records(std::istream& in) {
+    std::vector<GameRecord> games;
+    bool open = false;      // the last game can still take headers
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        std::istringstream ss(line);
+        std::string word;
+        if (!(ss >> word))
+            continue;
+        if (word == "#") {
+            std::string key, value;
+            ss >> key;
+            std::getline(ss >> std::ws, value);
+            if (key == "result" && !games.empty()) {
+                std::istringstream result(value);
+                std::string flag, x, y;
+                result >> games.back().winner >> flag;
+                games.back().invalid = flag == "invalid";
+                if (games.back().invalid)
+                    result >> x >> y >> games.back().reason;
+                open = false;
+            }
+            else if (key == "black" || key == "white") {
+                if (!open || !games.back().moves.empty()) {
+                    games.push_back(GameRecord());
+                    open = true;
+                }
+                (key == "black" ? games.back().black : games.back().white) = value;
+            }
+            continue;
+        }
+        if (!open || !games.back().moves.empty())
+            games.push_back(GameRecord());
+        open = true;
+        std::istringstream moves(line);
+        int x, y;
+        while (moves >> x >> y)
+            games.back().moves.push_back(Point(x, y));
+    }
+    return games;
+}
+
+// Status line of the board after `played` moves, as the arbiter prints it;
+// played = -1 asks for the turn line of the final board even if the game
+// ended there.
+std::string status_of(const GameRecord& game, const BitBoard& board, int played) {
+    bool final = played == (int)game.moves.size();
+    if (played < 0)
+        played = (int)game.moves.size();
+    int last = played % 2 ? BLACK : WHITE;    // who made move `played`
+    const char* name[3] = {"Draw", "O", "X"};
+    if (final) {
+        if (game.invalid)
+            return "Winner is " + game.winner + " (" + forfeit_text(game.reason) + ")";
+        if (played > 0 && board.is_five(game.moves[played - 1].x, game.moves[played - 1].y, last))
+            return std::string("Winner is ") + name[last];
+        if (played == BitBoard::SIZE * BitBoard::SIZE)
+            return "Winner is Draw";
+    }
+    return std::string(name[3 - last]) + "'s turn";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: replay record [timestep | all] [game]\n";
+        return 1;
+    }
+    std::ifstream fin(argv[1]);
+    if (!fin) {
+        std::cerr << "Error opening file: " << argv[1] << "\n";
+        return 1;
+    }
+    std::vector<GameRecord> games = read_records(fin);
+    int index = argc > 3 ? atoi(argv[3]) : 1;
+    if (index < 1 || index > (int)games.size()) {
+        std::cerr << "No game " << index << " in " << argv[1] << " (" << games.size() << " games)\n";
+        return 1;
+    }
+    const GameRecord& game = games[index - 1];
+    int last = (int)game.moves.size() + 1;
+    bool all = argc > 2 && std::string(argv[2]) == "all";
+    int from = all ? 1 : argc > 2 ? atoi(argv[2]) : last;
+    int to = all ? last : from;
+    if (from < 1 || from > last) {
+        std::cerr << "Timestep " << argv[2] << " out of range 1.." << last << "\n";
+        return 1;
+    }
+    if (!game.black.empty())
+        std::cout << "Player Black File: " << game.black << "\nPlayer White File: " << game.white << "\n";
+    BitBoard board;
+    std::string out;
+    for (int t = 1; t <= to; t++) {
+        if (t > 1) {
+            Point p = game.moves[t - 2];
+            if (!BitBoard::is_on_board(p.x, p.y) || board.get(p.x, p.y) != EMPTY) {
+                std::cerr << "Move " << t - 1 << " (" << p.x << ',' << p.y << ") is invalid\n";
+                return 1;
+            }
+            board.place(p.x, p.y, t % 2 == 0 ? BLACK : WHITE);
+        }
+        if (t >= from) {
+            out.clear();
+            // The arbiter shows the board once more, unchanged, after an
+            // invalid final move.
+            if (all && t == last && game.invalid)
+                render_board(out, board, t, status_of(game, board, -1));
+            render_board(out, board, t, status_of(game, board, t - 1));
+            std::cout << out;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+#ifndef STATE_FORMAT_H
+#define STATE_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include "mapped_file.h"
+
+// Binary state file, the optional alternative to the text state. It has a
+// fixed layout a player maps and reads in place:
+//   magic "GMKS", version, board size, win length, side to move
+//   the moves played so far, as x * size + y in order, one byte each on
+//   boards of up to 256 cells and two bytes each on larger ones
+//   the board, 2 bits per cell in row-major order (0 empty, 1 black,
+//   2 white), four cells to a byte starting from the low bits
+// Players tell the formats apart by the magic, so the arbiter may write
+// either to the same path. A state for another game (board size or win
+// length) is not taken as a binary state. Self-contained so every player
+// can include it; the game is BOARD_SIZE and BOARD_WIN_LENGTH, as in
+// bitboard.h.
+
+#ifndef BOARD_SIZE
+#define BOARD_SIZE 15
+#endif
+#ifndef BOARD_WIN_LENGTH
+#define BOARD_WIN_LENGTH 5
+#endif
+
+const int STATE_SIZE = BOARD_SIZE;
+const int STATE_WIN_LENGTH = BOARD_WIN_LENGTH;
+const int STATE_CELLS = STATE_SIZE * STATE_SIZE;
+typedef std::conditional<STATE_CELLS <= 256, uint8_t, uint16_t>::type StateMove;
+const char STATE_MAGIC[4] = {'G', 'M', 'K', 'S'};
+const int STATE_VERSION = 2;
+
+struct BinaryState {
+    char magic[4];
+    uint8_t version;
+    uint8_t board_size;
+    uint8_t win_length;
+    uint8_t to_move;
+    uint16_t move_count;
+    StateMove moves[STATE_CELLS];
+    uint8_t board[(STATE_CELLS + 3) / 4];
+
+    void clear(int player) {
+        memset(this, 0, sizeof(*this));
+        memcpy(magic, STATE_MAGIC, sizeof(STATE_MAGIC));
+        version = STATE_VERSION;
+        board_size = STATE_SIZE;
+        win_length = STATE_WIN_LENGTH;
+        to_move = player;
+    }
+    int cell(int x, int y) const {
+        int i = x * STATE_SIZE + y;
+        return (board[i >> 2] >> ((i & 3) * 2)) & 3;
+    }
+    // Records a move; the side to move is left to the caller.
+    void play(int x, int y, int disc) {
+        int i = x * STATE_SIZE + y;
+        board[i >> 2] |= disc << ((i & 3) * 2);
+        moves[move_count++] = i;
+    }
+    bool write(const char* path) const {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(this), sizeof(*this));
+        return (bool)out;
+    }
+};
+
+// A state file mapped for reading. state() is null if the file is not a
+// binary state, in which case it should be read as text.
+class StateFile {
+public:
+    bool open(const char* path) {
+        if (!file.open(path))
+            return false;
+        if (file.size() < sizeof(BinaryState) || memcmp(file.data(), STATE_MAGIC, sizeof(STATE_MAGIC)) != 0
+            || state()->version != STATE_VERSION || state()->board_size != STATE_SIZE
+            || state()->win_length != STATE_WIN_LENGTH || !valid(*state())) {
+            file.close();
+            return false;
+        }
+        return true;
+    }
+    const BinaryState* state() const {
+        return reinterpret_cast<const BinaryState*>(file.data());
+    }
+
+private:
+    MappedFile file;
+
+    // The header and move list can be read without going off the board: a
+    // side to move, at most STATE_CELLS moves, each on a different cell
+    // that holds a stone.
+    static bool valid(const BinaryState& state) {
+        if ((state.to_move != 1 && state.to_move != 2) || state.move_count > STATE_CELLS)
+            return false;
+        bool seen[STATE_CELLS] = {};
+        for (int i = 0; i < state.move_count; i++) {
+            int cell = state.moves[i];
+            if (cell >= STATE_CELLS || seen[cell])
+                return false;
+            int disc = state.cell(cell / STATE_SIZE, cell % STATE_SIZE);
+            if (disc != 1 && disc != 2)
+                return false;
+            seen[cell] = true;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <ostream>
+#include <iomanip>
+
+// Search statistics, compiled in with -DSEARCH_STATS (make attempt_stats).
+// Every search thread counts into its own SearchStats, so no counter is
+// shared; the report adds them up. Without SEARCH_STATS the STAT macros
+// expand to nothing and no counter exists.
+
+#ifdef SEARCH_STATS
+#define STAT(counter) (stats.counter++)
+#define STAT_IF(cond, counter) ((cond) ? (void)stats.counter++ : (void)0)
+#else
+#define STAT(counter) ((void)0)
+#define STAT_IF(cond, counter) ((void)0)
+#endif
+
+const int STATS_MAX_ITERATIONS = 64;
+
+struct SearchStats {
+    long long leaf_evals;
+    long long interior;             // nodes that searched at least one move
+    long long cutoffs;              // of those, nodes that failed high
+    long long first_move_cutoffs;   // ... on the first move searched
+    long long tt_probes;
+    long long tt_hits;
+    long long tt_cutoffs;
+    int iterations;                 // main thread only
+    int iteration_depth[STATS_MAX_ITERATIONS];
+    long long iteration_nodes[STATS_MAX_ITERATIONS];
+    int iteration_ms[STATS_MAX_ITERATIONS];
+
+    SearchStats() {
+        clear();
+    }
+    void clear() {
+        leaf_evals = interior = cutoffs = first_move_cutoffs = 0;
+        tt_probes = tt_hits = tt_cutoffs = 0;
+        iterations = 0;
+    }
+    void add(const SearchStats& other) {
+        leaf_evals += other.leaf_evals;
+        interior += other.interior;
+        cutoffs += other.cutoffs;
+        first_move_cutoffs += other.first_move_cutoffs;
+        tt_probes += other.tt_probes;
+        tt_hits += other.tt_hits;
+        tt_cutoffs += other.tt_cutoffs;
+    }
+    void iteration(int depth, long long nodes, int ms) {
+        if (iterations < STATS_MAX_ITERATIONS) {
+            iteration_depth[iterations] = depth;
+            iteration_nodes[iterations] = nodes;
+            iteration_ms[iterations] = ms;
+            iterations++;
+        }
+    }
+
+    // One line per completed iteration, with the effective branching factor
+    // against the previous one, then the totals over all threads.
+    void report(std::ostream& out, long long nodes, int threads) const {
+        for (int i = 0; i < iterations; i++) {
+            out << "stats depth " << iteration_depth[i] << " nodes " << iteration_nodes[i]
+                << " time " << iteration_ms[i] << "ms";
+            if (i > 0 && iteration_nodes[i - 1] > 0)
+                out << " ebf " << std::fixed << std::setprecision(2)
+                    << (double)iteration_nodes[i] / iteration_nodes[i - 1] << std::defaultfloat;
+            out << "\n";
+        }
+        out << "stats threads " << threads << " nodes " << nodes << " leaf_evals " << leaf_evals
+            << " interior " << interior
+            << " cutoffs " << cutoffs << " (" << percent(cutoffs, interior) << "%)"
+            << " first_move_cutoffs " << first_move_cutoffs << " (" << percent(first_move_cutoffs, cutoffs) << "%)"
+            << " tt_probes " << tt_probes << " tt_hits " << tt_hits << " (" << percent(tt_hits, tt_probes) << "%)"
+            << " tt_cutoffs " << tt_cutoffs << std::endl;
+    }
+
+private:
+    static double percent(long long part, long long whole) {
+        return whole > 0 ? (double)(1000 * part / whole) / 10 : 0.0;
+    }
+};
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef THREATS_H
+#define THREATS_H
+
+#include <chrono>
+
+#include "bitboard.h"
+
+// Threat-space search. The attacker only plays moves that leave the
+// defender a short list of replies, which keeps the tree narrow enough to
+// read long forcing sequences:
+//   VCF  victory by continuous fours: every attacking move makes a four and
+//        the only reply is to block its five point.
+//   VCT  victory by continuous threats: attacking moves may also make an
+//        open three, answered by blocking it or by a counter-four.
+// The defender is allowed every counter-four, so a defender who can start
+// forcing play of its own refutes a three.
+
+// A set of cells as one row mask per board row.
+struct CellSet {
+    BitBoard::Line rows[BitBoard::SIZE];
+
+    CellSet() {
+        for (int x = 0; x < BitBoard::SIZE; x++)
+            rows[x] = 0;
+    }
+    void add(Point p) {
+        rows[p.x] |= BitBoard::Line(1) << p.y;
+    }
+    // Adds every set bit of a line word.
+    void add_line(int line, BitBoard::Line bits) {
+        while (bits) {
+            add(BitBoard::cell_of(line, __builtin_ctz(bits)));
+            bits &= bits - 1;
+        }
+    }
+    int count() const {
+        int n = 0;
+        for (int x = 0; x < BitBoard::SIZE; x++)
+            n += __builtin_popcount(rows[x]);
+        return n;
+    }
+    int list(Point* out) const {
+        int n = 0;
+        for (int x = 0; x < BitBoard::SIZE; x++) {
+            BitBoard::Line r = rows[x];
+            while (r) {
+                out[n++] = Point(x, __builtin_ctz(r));
+                r &= r - 1;
+            }
+        }
+        return n;
+    }
+};
+
+class ThreatSolver {
+public:
+    typedef BitBoard::Line Line;
+    static const int SIZE = BitBoard::SIZE;
+    static const int WIN = BitBoard::WIN_LENGTH;
+
+    long long nodes;
+
+    explicit ThreatSolver(const BitBoard& root)
+        : nodes(0), board(root), max_nodes(1 << 20), deadline(std::chrono::steady_clock::time_point::max()), aborted(false) {}
+
+    void set_limits(long long node_limit, std::chrono::steady_clock::time_point time_limit) {
+        max_nodes = node_limit;
+        deadline = time_limit;
+    }
+    // Looks for a forced win for attacker, who is to move, using at most
+    // depth attacking moves. With threes == false only fours are tried (VCF).
+    // Depths are tried in increasing order so the shortest win is played;
+    // otherwise a later move may switch to another, longer win and never
+    // finish it.
+    bool solve(int attacker, bool threes, int depth, Point& move) {
+        nodes = 0;
+        aborted = false;
+        use_threes = threes;
+        for (int d = 1; d <= depth && !aborted; d++)
+            if (attack(attacker, d, &move))
+                return true;
+        return false;
+    }
+
+    // Line-level shapes, as masks of empty cells on one line word.
+    // Cells that complete WIN in a row.
+    static Line five_cells(Line own, Line opp, Line mask) {
+        return span_cells(own, opp, mask, WIN - 1);
+    }
+    // Cells that make a four (a line with a five point).
+    static Line four_cells(Line own, Line opp, Line mask) {
+        return span_cells(own, opp, mask, WIN - 2);
+    }
+    // Cells that make an open three.
+    static Line three_cells(Line own, Line opp, Line mask) {
+        Line cells = 0, d;
+        open_windows(own, opp, mask, WIN - 3, cells, d);
+        return cells;
+    }
+    // Cells that stop every open four the line could become.
+    static Line three_defence_cells(Line own, Line opp, Line mask) {
+        Line cells = 0, defence = 0;
+        open_windows(own, opp, mask, WIN - 2, cells, defence);
+        return defence;
+    }
+
+private:
+    BitBoard board;
+    long long max_nodes;
+    std::chrono::steady_clock::time_point deadline;
+    bool aborted;
+    bool use_threes;
+
+    // Empty cells of WIN-wide windows holding `stones` stones and no
+    // blocked cell.
+    static Line span_cells(Line own, Line opp, Line mask, int stones) {
+        Line empty = mask & ~(own | opp);
+        Line cells = 0;
+        for (int p = 0; p + WIN <= SIZE; p++) {
+            Line m = ((Line(1) << WIN) - 1) << p;
+            if ((m & ~mask) || (m & opp))
+                continue;
+            if (__builtin_popcount(own & m) == stones)
+                cells |= m & empty;
+        }
+        return cells;
+    }
+    // Windows of WIN + 1 cells with empty ends and `stones` stones inside;
+    // collects their inner empty cells and, as defence, those plus the ends.
+    static void open_windows(Line own, Line opp, Line mask, int stones, Line& cells, Line& defence) {
+        Line empty = mask & ~(own | opp);
+        for (int p = 0; p + WIN + 1 <= SIZE; p++) {
+            Line m = ((Line(1) << (WIN + 1)) - 1) << p;
+            Line ends = (Line(1) << p) | (Line(1) << (p + WIN));
+            Line inner = m & ~ends;
+            if ((m & ~mask) || (m & opp) || (own & ends))
+                continue;
+            if (__builtin_popcount(own & inner) == stones) {
+                cells |= inner & empty;
+                defence |= m & empty;
+            }
+        }
+    }
+
+    typedef Line (*LineShape)(Line, Line, Line);
+    CellSet collect(int disc, LineShape shape) const {
+        CellSet set;
+        const Line* own = board.stones[disc - 1];
+        const Line* opp = board.stones[2 - disc];
+        for (int l = 0; l < BitBoard::LINES; l++)
+            if (own[l])
+                set.add_line(l, shape(own[l], opp[l], BitBoard::line_mask(l)));
+        return set;
+    }
+
+    bool out_of_budget() {
+        if (++nodes >= max_nodes || ((nodes & 255) == 0 && std::chrono::steady_clock::now() >= deadline))
+            aborted = true;
+        return aborted;
+    }
+
+    // Attacker to move.
+    bool attack(int attacker, int depth, Point* move) {
+        if (out_of_budget())
+            return false;
+        int defender = 3 - attacker;
+        Point cells[SIZE * SIZE];
+        CellSet fives = collect(attacker, five_cells);
+        if (fives.count() > 0) {
+            if (move) {
+                fives.list(cells);
+                *move = cells[0];
+            }
+            return true;
+        }
+        CellSet threats = collect(defender, five_cells);
+        int forced = threats.count();
+        if (forced >= 2 || depth <= 0)
+            return false;
+        int n;
+        if (forced == 1) {
+            n = threats.list(cells);
+        }
+        else {
+            n = collect(attacker, four_cells).list(cells);
+            if (use_threes) {
+                CellSet threes = collect(attacker, three_cells);
+                for (int i = 0; i < n; i++)
+                    threes.rows[cells[i].x] &= ~(Line(1) << cells[i].y);
+                n += threes.list(cells + n);
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            board.place(cells[i].x, cells[i].y, attacker);
+            bool win = defend(attacker, depth - 1);
+            board.remove(cells[i].x, cells[i].y, attacker);
+            if (win) {
+                if (move)
+                    *move = cells[i];
+                return true;
+            }
+            if (aborted)
+                return false;
+        }
+        return false;
+    }
+
+    // Defender to move after an attacking move; true if every reply loses.
+    bool defend(int attacker, int depth) {
+        if (out_of_budget())
+            return false;
+        int defender = 3 - attacker;
+        if (collect(defender, five_cells).count() > 0)
+            return false;
+        Point cells[SIZE * SIZE];
+        CellSet fives = collect(attacker, five_cells);
+        int n = fives.count();
+        if (n >= 2)
+            return true;
+        if (n == 1) {
+            fives.list(cells);
+        }
+        else {
+            if (!use_threes)
+                return false;
+            CellSet replies = collect(attacker, three_defence_cells);
+            if (replies.count() == 0)
+                return false;
+            CellSet counters = collect(defender, four_cells);
+            for (int x = 0; x < SIZE; x++)
+                replies.rows[x] |= counters.rows[x];
+            n = replies.list(cells);
+        }
+        for (int i = 0; i < n; i++) {
+            board.place(cells[i].x, cells[i].y, defender);
+            bool win = attack(attacker, depth, nullptr);
+            board.remove(cells[i].x, cells[i].y, defender);
+            if (!win)
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif
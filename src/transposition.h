@@ -0,0 +1,160 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+// Fixed-size transposition table shared by all search threads. Entries are
+// 16 bytes and grouped four to a 64-byte, cache-line aligned bucket, so a
+// probe touches one cache line. The bucket is picked by the low bits of the
+// key.
+//
+// The table is lock-free: a slot holds its packed data word and the key
+// XOR-ed with that word, each written with a relaxed atomic store. A slot torn
+// by two threads writing at once no longer XORs back to a key and is treated
+// as a miss, so readers never see a mix of two positions.
+//
+// Replacement: an entry for the same position is overwritten unless it was
+// searched at least three plies deeper in the current search. Otherwise the
+// victim is the entry with the lowest depth, where entries left over from
+// earlier searches count as eight plies shallower per search of age.
+
+struct TTEntry {
+    int score;
+    int depth;
+    int bound;
+    int move;
+    int age;
+};
+
+struct TTSlot {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+};
+
+struct alignas(64) TTBucket {
+    TTSlot slots[4];
+};
+// resize() takes the buckets straight from calloc: all-zero slots are empty.
+static_assert(std::is_trivially_default_constructible<TTBucket>::value, "buckets are not constructed");
+
+class TranspositionTable {
+public:
+    enum BOUND {
+        BOUND_NONE = 0,
+        BOUND_UPPER = 1,
+        BOUND_LOWER = 2,
+        BOUND_EXACT = 3
+    };
+    // Moves are cells, x * SIZE + y; an entry without one has NO_MOVE.
+    static const int NO_MOVE = -1;
+
+    TranspositionTable() : memory(nullptr), buckets(nullptr), mask(0), age(0) {}
+    ~TranspositionTable() {
+        free(memory);
+    }
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Uses the largest power-of-two number of buckets within the budget. The
+    // table comes zeroed from calloc, which for a large block maps zero pages
+    // as they are first touched, so a new table costs nothing up front.
+    void resize(size_t megabytes) {
+        size_t count = 1;
+        while (count * 2 * sizeof(TTBucket) <= megabytes * 1024 * 1024)
+            count *= 2;
+        free(memory);
+        memory = static_cast<char*>(calloc(count * sizeof(TTBucket) + alignof(TTBucket), 1));
+        if (!memory)
+            throw std::bad_alloc();
+        size_t offset = (alignof(TTBucket) - reinterpret_cast<uintptr_t>(memory) % alignof(TTBucket)) % alignof(TTBucket);
+        buckets = reinterpret_cast<TTBucket*>(memory + offset);
+        mask = count - 1;
+        age = 0;
+    }
+    // Empties a table that has been searched with.
+    void clear() {
+        for (size_t i = 0; i <= mask; i++) {
+            for (int j = 0; j < 4; j++) {
+                buckets[i].slots[j].check.store(0, std::memory_order_relaxed);
+                buckets[i].slots[j].data.store(0, std::memory_order_relaxed);
+            }
+        }
+        age = 0;
+    }
+    // Call once per root search, before starting the threads, so older
+    // entries age out.
+    void new_search() {
+        age++;
+    }
+    bool probe(uint64_t key, TTEntry& out) const {
+        const TTBucket& bucket = buckets[key & mask];
+        for (int i = 0; i < 4; i++) {
+            uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+            uint64_t check = bucket.slots[i].check.load(std::memory_order_relaxed);
+            if ((check ^ data) == key && unpack(data, out).bound != BOUND_NONE)
+                return true;
+        }
+        return false;
+    }
+    void store(uint64_t key, int depth, int bound, int score, int move) {
+        TTBucket& bucket = buckets[key & mask];
+        TTSlot* victim = &bucket.slots[0];
+        int victim_worth = 1 << 30;
+        for (int i = 0; i < 4; i++) {
+            TTSlot& slot = bucket.slots[i];
+            TTEntry e;
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            unpack(data, e);
+            if ((slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+                if (e.age == age && e.depth > depth + 2 && bound != BOUND_EXACT)
+                    return;
+                if (move == NO_MOVE)
+                    move = e.move;
+                victim = &slot;
+                break;
+            }
+            int worth = e.bound == BOUND_NONE ? -(1 << 30) : e.depth - 8 * (uint8_t)(age - e.age);
+            if (worth < victim_worth) {
+                victim = &slot;
+                victim_worth = worth;
+            }
+        }
+        uint64_t data = pack(depth, bound, score, move);
+        victim->data.store(data, std::memory_order_relaxed);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+private:
+    char* memory;
+    TTBucket* buckets;
+    size_t mask;
+    uint8_t age;
+
+    // score:32 | depth:8 | bound:2 | move:14 | age:8. 14 bits cover the
+    // cells of boards up to 128 x 128; all ones packs NO_MOVE.
+    static const int MOVE_FIELD = 0x3fff;
+
+    uint64_t pack(int depth, int bound, int score, int move) const {
+        return (uint64_t)(uint32_t)score
+             | (uint64_t)(uint8_t)depth << 32
+             | (uint64_t)(bound & 3) << 40
+             | (uint64_t)(move == NO_MOVE ? MOVE_FIELD : move & MOVE_FIELD) << 42
+             | (uint64_t)age << 56;
+    }
+    static const TTEntry& unpack(uint64_t data, TTEntry& e) {
+        int move = (data >> 42) & MOVE_FIELD;
+        e.score = (int32_t)(uint32_t)data;
+        e.depth = (int8_t)(data >> 32);
+        e.bound = (data >> 40) & 3;
+        e.move = move == MOVE_FIELD ? NO_MOVE : move;
+        e.age = (uint8_t)(data >> 56);
+        return e;
+    }
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+#include "bitboard.h"
+
+// 64-bit Zobrist keys, one per colour and cell, generated at compile time
+// from a fixed splitmix64 stream so every build (and every opening book
+// built from it) agrees on the same hashes. A position's key is the XOR of
+// the keys of its stones; placing or removing a stone XORs one key.
+
+const int ZOBRIST_CELLS = BitBoard::SIZE * BitBoard::SIZE;
+
+struct ZobristKeys {
+    uint64_t stone[2][ZOBRIST_CELLS];
+};
+
+constexpr uint64_t splitmix64(uint64_t& state) {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys make_zobrist_keys() {
+    ZobristKeys keys{};
+    uint64_t state = 0x676F6D6F6B75ULL;
+    for (int c = 0; c < 2; c++)
+        for (int i = 0; i < ZOBRIST_CELLS; i++)
+            keys.stone[c][i] = splitmix64(state);
+    return keys;
+}
+
+constexpr ZobristKeys zobrist = make_zobrist_keys();
+
+inline uint64_t zobrist_key(int x, int y, int disc) {
+    return zobrist.stone[disc - 1][x * BitBoard::SIZE + y];
+}
+
+// Key of a whole position, for setting up a root.
+inline uint64_t zobrist_hash(const BitBoard& board) {
+    uint64_t key = 0;
+    for (int x = 0; x < BitBoard::SIZE; x++)
+        for (int y = 0; y < BitBoard::SIZE; y++)
+            if (board.get(x, y) != EMPTY)
+                key ^= zobrist_key(x, y, board.get(x, y));
+    return key;
+}
+
+#endif